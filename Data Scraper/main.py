@@ -15,7 +15,34 @@ csv_cols = [
     "propagations",
     "nodes",
     "failures",
-    "peak depth"
+    "peak depth",
+    "modulo posts",
+    "modulo posted",
+    "modulo payoff",
+    "presolve decided",
+    "presolve time",
+    "exact solutions",
+    "count method",
+    "count runtime",
+    "profile clone Eq20",
+    "profile clone Modulo",
+    "profile print",
+    "profile branch",
+    "profile propagate linear",
+    "profile propagate Modulo",
+    "profile propagate ModuloTer",
+    "profile propagate ModuloBounds",
+    "profile other",
+    "profile total",
+    "bab rounded",
+    "bab snapped",
+    "recompute c_d",
+    "recompute a_d",
+    "recompute clone",
+    "recompute step",
+    "incremental boxes",
+    "incremental reused",
+    "incremental carried"
 ]
 
 csv_filename = "output.csv"
@@ -28,10 +55,31 @@ def parse_file(filename: str) -> dict:
         data = {"timeout": False}
         for line in infile:
             match line.strip().split(':'):
-                case ["runtime" as key, time]:
+                case [("runtime" | "count runtime") as key, time]:
                     data[key] = float(time.strip().split(" ")[0])
-                case [("solutions" | "propagations" | "nodes" | "failures" | "peak depth") as key, value]:
+                case ["exact solutions" as key, value]:
                     data[key] = int(value.strip())
+                case ["count method" as key, value]:
+                    data[key] = value.strip()
+                case [("solutions" | "propagations" | "nodes" | "failures" | "peak depth"
+                       | "modulo posts" | "modulo posted" | "bab rounded" | "bab snapped"
+                       | "recompute c_d" | "recompute a_d" | "incremental boxes" | "incremental reused"
+                       | "incremental carried") as key, value]:
+                    data[key] = int(value.strip())
+                case ["modulo payoff" as key, value]:
+                    data[key] = float(value.strip())
+                case [("recompute clone" | "recompute step") as key, value]:
+                    # ns
+                    data[key] = float(value.strip().split(" ")[0])
+                case ["modulo presolve time", value]:
+                    # ms
+                    data["presolve time"] = float(value.strip().split(" ")[0])
+                case ["modulo presolve", value]:
+                    counts = value.strip().split("/")
+                    data["presolve decided"] = int(counts[3])
+                case [key, value] if key.startswith("profile "):
+                    # wall time in ms
+                    data[key] = float(value.strip().split(" ")[0])
                 case ["reason", " time limit reached"]:
                     data["timeout"] = True
                 case _:
@@ -67,13 +115,16 @@ def main(directory: str):
         match filename.split("_"):
             # LOG_<solutions>_<TestType>_<domain increases>_<id>_<propagator>.txt
             case [
-                "LOG", sols, ("B" | "X" | "R") as test, dom, num,
-                ("AdvModulo.txt" | "Modulo.txt" | "Linear.txt") as prop
-            ]:
+                "LOG", sols, ("B" | "X" | "R" | "M" | "F" | "C" | "S" | "W") as test, dom, num, prop
+            ] if prop.removesuffix(".txt").removesuffix("BAB").removesuffix("C") in (
+                "AdvModulo", "Modulo", "Linear", "AutoModulo", "AutoAdvModulo"):
                 if test == "R":
                     dom = int(dom) - 250
-                else:
+                elif test in ("B", "X"):
                     dom = int(dom) - 10
+                else:
+                    # generated families start at group 0
+                    dom = int(dom)
                 data = parse_file(directory + "\\" + filename) | {
                     "requested solutions": int(sols),
                     "test type": test,
@@ -36,6 +36,23 @@
 
 #include "modulo_propogator.hpp"
 #include "modulo-Instances.hh"
+#include "modulo-Corpus.hh"
+#include "modulo-Generators.hh"
+#include "modulo-Stats.hh"
+#include "modulo-Count.hh"
+#include "modulo-Cache.hh"
+#include "modulo-Sink.hh"
+#include "modulo-Recompute.hh"
+#include "modulo-Batch.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <map>
 
 using namespace Gecode;
 
@@ -43,6 +60,144 @@ static int domains[2];
 static std::vector<std::vector<int>> a_is;
 static int next_id = 0;
 
+/// Options for the test harness
+class ModOptions : public Options {
+protected:
+    Driver::StringValueOption _corpus; ///< corpus file to run
+    Driver::StringOption _suite;       ///< suite to generate when the corpus file is missing
+    Driver::UnsignedIntOption _seed;   ///< seed for the generated families
+    Driver::UnsignedIntOption _size;   ///< size parameter for the generated families
+    Driver::UnsignedIntOption _count;  ///< instances to generate
+    Driver::StringOption _regress;     ///< regression benchmark mode
+    Driver::StringValueOption _baseline; ///< regression baseline file
+    Driver::UnsignedIntOption _runs;   ///< runs per instance and propagation in regression mode
+    Driver::UnsignedIntOption _regress_n; ///< instances in regression mode
+    Driver::DoubleOption _threshold;   ///< allowed relative slowdown
+    Driver::BoolOption _counting;      ///< report exact solution counts
+    Driver::UnsignedIntOption _count_memory; ///< memory for the counting tables
+    Driver::StringValueOption _cache;  ///< result cache directory
+    Driver::StringOption _sink;        ///< where solutions go
+    Driver::UnsignedIntOption _sink_batch; ///< solutions buffered per write
+    Driver::BoolOption _dedupe;        ///< drop repeated solutions in the sink
+    Driver::BoolOption _profile;       ///< time the search phases
+    Driver::UnsignedIntOption _profile_sample; ///< time every n-th call of a phase
+    Driver::StringValueOption _profile_file; ///< folded stacks output
+    Driver::StringOption _optimise;    ///< minimise a linear cost with BAB
+    Driver::StringOption _objective;   ///< objective weights
+    Driver::BoolOption _recompute;     ///< choose c_d and a_d from probed costs
+    Driver::UnsignedIntOption _batch;  ///< right hand sides per equation in batch mode
+    Driver::BoolOption _incremental;   ///< search only what a larger domain adds
+public:
+    enum {
+        REGRESS_OFF,     ///< normal sweep
+        REGRESS_RECORD,  ///< store a baseline
+        REGRESS_COMPARE  ///< compare against a stored baseline
+    };
+    enum {
+        OPT_OFF,         ///< satisfaction with DFS
+        OPT_PLAIN,       ///< BAB, bounds as given by the solutions
+        OPT_CONGRUENCE   ///< BAB, bounds rounded by the congruences
+    };
+    enum {
+        OBJ_SUM,         ///< minimise the sum of the variables
+        OBJ_WEIGHTED     ///< random weights in 1..10 from the seed
+    };
+    ModOptions(const char* s)
+        : Options(s),
+        _corpus("corpus", "instance corpus file (generated from -suite if missing)"),
+        _suite("suite", "test suite to generate", RANDOM),
+        _seed("seed", "seed for generated suites", 1000),
+        _size("size", "equations (market, multi) or terms (others) of generated suites", 4),
+        _count("instances", "instances in generated suites", 250),
+        _regress("regress", "regression benchmark mode", REGRESS_OFF),
+        _baseline("baseline", "regression baseline file", "Regress/baseline.csv"),
+        _runs("runs", "runs per instance and propagation in regression mode", 5),
+        _regress_n("regress-instances", "instances used in regression mode", 50),
+        _threshold("threshold", "allowed relative slowdown in regression mode", 0.05),
+        _counting("counting", "count solutions without search where it fits, next to the search statistics", false),
+        _count_memory("count-memory", "memory for the counting tables in MB", 256),
+        _cache("cache", "result cache directory, runs found there are not repeated"),
+        _sink("sink", "where solutions go", Sink::PRINT),
+        _sink_batch("sink-batch", "solutions buffered per write of the sink", 4096),
+        _dedupe("dedupe", "drop repeated solutions in the sink", false),
+        _profile("profile", "time cloning, printing and the modulo propagators", false),
+        _profile_sample("profile-sample", "time every n-th call of a phase", 16),
+        _profile_file("profile-file", "append folded stacks for flame graphs to this file"),
+        _optimise("optimise", "minimise a linear cost with BAB", OPT_OFF),
+        _objective("objective", "objective weights", OBJ_SUM),
+        _recompute("recompute", "choose c_d and a_d per instance family from probed clone and recomputation cost", false),
+        _batch("batch", "solve every equation for this many right hand sides instead of the sweep (0 = off)", 0),
+        _incremental("incremental", "reuse the solutions of the same equations over a smaller domain and search only the added region", false) {
+        _suite.add(BASIC, "basic");
+        _suite.add(XOR, "xor");
+        _suite.add(RANDOM, "random");
+        _suite.add(Generators::MARKET_SPLIT, "market");
+        _suite.add(Generators::NEAR_FROBENIUS, "frobenius");
+        _suite.add(Generators::INFEASIBLE_CONGRUENCE, "congruence");
+        _suite.add(Generators::MULTI_EQUATION, "multi");
+        _suite.add(Generators::WIDE, "wide");
+        add(_corpus);
+        add(_suite);
+        add(_seed);
+        add(_size);
+        add(_count);
+        _regress.add(REGRESS_OFF, "off");
+        _regress.add(REGRESS_RECORD, "record");
+        _regress.add(REGRESS_COMPARE, "compare");
+        add(_regress);
+        add(_baseline);
+        add(_runs);
+        add(_regress_n);
+        add(_threshold);
+        add(_counting);
+        add(_count_memory);
+        add(_cache);
+        _sink.add(Sink::PRINT, "print");
+        _sink.add(Sink::BINARY, "binary");
+        _sink.add(Sink::COUNT, "count");
+        add(_sink);
+        add(_sink_batch);
+        add(_dedupe);
+        add(_profile);
+        add(_profile_sample);
+        add(_profile_file);
+        _optimise.add(OPT_OFF, "off");
+        _optimise.add(OPT_PLAIN, "plain");
+        _optimise.add(OPT_CONGRUENCE, "congruence");
+        add(_optimise);
+        _objective.add(OBJ_SUM, "sum");
+        _objective.add(OBJ_WEIGHTED, "weighted");
+        add(_objective);
+        add(_recompute);
+        add(_batch);
+        add(_incremental);
+    }
+    const char* corpus(void) const { return _corpus.value(); }
+    int suite(void) const { return _suite.value(); }
+    unsigned int seed(void) const { return _seed.value(); }
+    unsigned int size(void) const { return _size.value(); }
+    unsigned int instances(void) const { return _count.value(); }
+    int regress(void) const { return _regress.value(); }
+    const char* baseline(void) const { return _baseline.value(); }
+    unsigned int runs(void) const { return _runs.value(); }
+    unsigned int regress_instances(void) const { return _regress_n.value(); }
+    double threshold(void) const { return _threshold.value(); }
+    bool counting(void) const { return _counting.value(); }
+    size_t count_memory(void) const { return (size_t)_count_memory.value() << 20; }
+    const char* cache(void) const { return _cache.value(); }
+    int sink(void) const { return _sink.value(); }
+    unsigned int sink_batch(void) const { return _sink_batch.value(); }
+    bool dedupe(void) const { return _dedupe.value(); }
+    bool profile(void) const { return _profile.value(); }
+    unsigned int profile_sample(void) const { return _profile_sample.value(); }
+    const char* profile_file(void) const { return _profile_file.value(); }
+    int optimise(void) const { return _optimise.value(); }
+    int objective(void) const { return _objective.value(); }
+    bool recompute(void) const { return _recompute.value(); }
+    unsigned int batch(void) const { return _batch.value(); }
+    bool incremental(void) const { return _incremental.value(); }
+};
+
 /**
  * \brief %Example: Solving 20 linear equations
  *
@@ -58,11 +213,42 @@ private:
     std::vector<std::vector<int>> coefficients;
     int id = 0;
 public:
+    /// Sink taking the solutions instead of print, if active
+    static Sink::Sink* sink;
+    /// Classes and memo kept per equation by an incremental sweep, if any
+    static std::vector<Mod::Carry>* carry;
+
     enum {
         PROP_LINEAR,  ///< Use regular constraints
-        PROP_MODULO    ///< Use custom constraint
+        PROP_MODULO,   ///< Use custom constraint
+        PROP_MODULO_AUTO ///< Use custom constraint where the post-time analysis expects a payoff
     };
 
+    /// Post every equation with the propagation selected in \a opt, with their congruences in \a pub
+    /// and what carries over to the next post in \a cy if given
+    static void equations(Home home, const IntVarArray& x, const std::vector<std::vector<int>>& coefficients, const Options& opt,
+        std::vector<Mod::Published>* pub = nullptr, std::vector<Mod::Carry>* cy = nullptr) {
+        const int x_n = x.size();
+        if (cy != nullptr) cy->resize(coefficients.size());
+        for (size_t e = 0; e < coefficients.size(); e++) {
+            const std::vector<int>& ai = coefficients[e];
+            IntArgs c(x_n, &ai[1]);
+            Mod::Published* p = nullptr;
+            if (pub != nullptr) {
+                pub->emplace_back();
+                p = &pub->back();
+            }
+            Mod::Carry* k = cy != nullptr ? &(*cy)[e] : nullptr;
+            if (opt.propagation() == PROP_MODULO) {
+                modulo(home, c, x, ai[0], opt.ipl(), p, k);
+            } else if (opt.propagation() == PROP_MODULO_AUTO) {
+                modulo_auto(home, c, x, ai[0], opt.ipl(), p, k);
+            } else { //if (opt.propagation() == PROP_LINEAR) {
+                Profile::linear(home, c, x, ai[0], opt.ipl());
+            }
+        }
+    }
+
     /// The actual problem
     Eq20(const Options& opt)
         : Script(opt) {
@@ -72,15 +258,8 @@ public:
 
         const int x_n = coefficients[0].size() - 1;
         x = IntVarArray(*this, x_n, domains[0], domains[1]);
-        for (auto ai : coefficients) {
-            IntArgs c(x_n, &ai[1]);
-            if (opt.propagation() == PROP_MODULO) {
-                modulo(*this, c, x, ai[0], opt.ipl());
-            } else { //if (opt.propagation() == PROP_LINEAR) {
-                linear(*this, c, x, IRT_EQ, ai[0], opt.ipl());
-            }
-        }
-        branch(*this, x, INT_VAR_NONE(), INT_VAL_MIN());
+        equations(*this, x, coefficients, opt, nullptr, carry);
+        Profile::branch(*this, x);
     }
 
     /// Constructor for cloning \a s
@@ -92,87 +271,836 @@ public:
     /// Perform copying during cloning
     virtual Space*
         copy(void) {
+        PROFILE_SCOPE(Profile::CLONE_SCRIPT);
         return new Eq20(*this);
     }
     /// Print solution
     virtual void
         print(std::ostream& os) const {
+        PROFILE_SCOPE(Profile::PRINT);
+        if (sink != nullptr && sink->active()) {
+            sink->push(x);
+            return;
+        }
         os << "\tx[] = " << x << std::endl;
     }
 
+    /// Values of a solution
+    std::vector<int> values(void) const {
+        std::vector<int> v(x.size());
+        for (int i = 0; i < x.size(); i++) v[i] = x[i].val();
+        return v;
+    }
+    /// Restrict to the i-th part of the box added around [lo, hi]: x_0..x_i-1 inside, x_i outside
+    void added(int i, int lo, int hi) {
+        for (int j = 0; j < i; j++) dom(*this, x[j], lo, hi);
+        const int r[2][2] = { { Int::Limits::min, lo - 1 }, { hi + 1, Int::Limits::max } };
+        dom(*this, x[i], IntSet(r, 2));
+    }
 };
+Sink::Sink* Eq20::sink = nullptr;
+std::vector<Mod::Carry>* Eq20::carry = nullptr;
+
+// objective weights of the optimisation variant, set per instance like the other statics
+static std::vector<int> weights;
 
+/**
+ * \brief %Example: Minimising a linear cost over the equations
+ *
+ * With congruence bounding, every new bound is rounded down to the next cost the congruences of the
+ * equations at the current node still allow, and terms are snapped to the largest value of their
+ * class that can still beat the incumbent.
+ */
+class Eq20Opt : public IntMinimizeScript {
+private:
+    IntVarArray x;
+    IntVar c;   ///< cost
+    std::vector<std::vector<int>> coefficients;
+    std::vector<int> w;
+    std::vector<Mod::Published> pub;    ///< congruences Modulo keeps per equation
+    int id = 0;
+public:
+    /// Round bounds by congruence, plain BAB otherwise
+    static bool congruent;
+    /// Bounds tightened by rounding, and terms snapped to their class, counted by every engine thread
+    static std::atomic<unsigned long int> rounded, snapped;
+
+    Eq20Opt(const Options& opt)
+        : IntMinimizeScript(opt) {
+        id = next_id;
+        coefficients = a_is;
+        w = weights;
+
+        const int x_n = coefficients[0].size() - 1;
+        x = IntVarArray(*this, x_n, domains[0], domains[1]);
+        Eq20::equations(*this, x, coefficients, opt, &pub);
+
+        long long lo = 0, hi = 0;
+        for (int i = 0; i < x_n; i++) {
+            lo += std::min((long long)w[i] * domains[0], (long long)w[i] * domains[1]);
+            hi += std::max((long long)w[i] * domains[0], (long long)w[i] * domains[1]);
+        }
+        c = IntVar(*this, (int)std::max<long long>(lo, Int::Limits::min), (int)std::min<long long>(hi, Int::Limits::max));
+        Profile::linear(*this, IntArgs(w), x, c, opt.ipl());
+        Profile::branch(*this, x);
+    }
 
-void run_tests(Options& opt) {
-    //for (auto test_suite : { BASIC, XOR, RANDOM }) {
-    for (auto test_suite : { RANDOM }) {
-        std::vector<std::vector<int>> tests = generate_tests(test_suite, 250);
-
-        // init vars
-        int eq_num = 1;
-        int eq_counter = 0;
-        int term_num = 0;
-        int reset_num = 0;
-        // run the tests
-        for (auto const& test : tests) {
-            switch (test.size()) {
-                // reset id
-            case 0:
-                next_id = 0;
-                reset_num++;
-                break;
-                // update equation number per post
-            case 1:
-                eq_num = test[0];
-                break;
-                // update domain
-            case 2:
-                domains[0] = test[0];
-                domains[1] = test[1];
-                break;
-                // new post
-            default:
-                // get number of terms
-                term_num = test.size() - 1;
-
-                a_is.push_back(test);
-                // if new equation set
-                if (eq_num == ++eq_counter) {
-                    eq_counter = 0;
-
-                    for (auto const b : { Eq20::PROP_MODULO }) {
-                    //for (auto const b : { Eq20::PROP_MODULO, Eq20::PROP_LINEAR }) {
-                    //for (auto const b : { Eq20::PROP_LINEAR, Eq20::PROP_MODULO }) {
-
-                        // get the output filename
-                        std::stringstream filename;
-                        filename << "Out/LOG"
-                            << "_" << opt.solutions()
-                            << "_" << (test_suite == BASIC ? "B" : test_suite == XOR ? "X" : "R")
-                            << "_" << reset_num
-                            << "_" << next_id
-#if ADV_MOD:
-                            << "_" << (b == Eq20::PROP_LINEAR ? "Linear" : "AdvModulo")
+    Eq20Opt(Eq20Opt& s) : IntMinimizeScript(s) {
+        x.update(*this, s.x);
+        c.update(*this, s.c);
+        this->coefficients = s.coefficients;
+        this->w = s.w;
+        this->pub = s.pub;
+        for (size_t e = 0; e < pub.size(); e++)
+            if (s.pub[e].table.valid()) pub[e].table.update(*this, s.pub[e].table);
+        this->id = s.id;
+    }
+    virtual Space*
+        copy(void) {
+        PROFILE_SCOPE(Profile::CLONE_SCRIPT);
+        return new Eq20Opt(*this);
+    }
+    virtual IntVar cost(void) const {
+        return c;
+    }
+
+    /// Class of every unassigned variable from the equations at this node, false if one has none.
+    /// The classes Modulo derived are combined with those of the live terms of every equation.
+    bool classes(std::vector<Mod::ModDomain>& d) const {
+        const int n = x.size();
+        d.assign(n, Mod::ModDomain());
+        for (auto const& p : pub) {
+            if (!p.table.valid()) continue;
+            for (size_t k = 0; k < p.var.size(); k++) {
+                const int i = p.var[k];
+                if (i < 0 || x[i].assigned() || p.table[(int)k].mod <= 1) continue;
+                if (!Mod::crt(d[i], p.table[(int)k], d[i])) return false;
+            }
+        }
+        for (auto const& ai : coefficients) {
+            long long rhs = ai[0];
+            std::vector<int> live;
+            for (int i = 0; i < n; i++) {
+                if (ai[i + 1] == 0) continue;
+                if (x[i].assigned()) rhs -= (long long)ai[i + 1] * x[i].val();
+                else live.push_back(i);
+            }
+            // x_i = (a_i / g)^-1 (rhs / g) mod G_i / g, G_i the gcd of the other live terms
+            std::vector<long long> suf(live.size() + 1, 0);
+            for (size_t k = live.size(); k-- > 0; ) suf[k] = std::gcd(suf[k + 1], (long long)ai[live[k] + 1]);
+            long long pre = 0;
+            for (size_t k = 0; k < live.size(); k++) {
+                const long long a = ai[live[k] + 1];
+                const long long G = std::gcd(pre, suf[k + 1]);
+                pre = std::gcd(pre, a);
+                if (G <= 1) continue;
+                Mod::ModDomain dk;
+                if (!Mod::congruence(a, G, rhs, dk)) return false;
+                if (!Mod::crt(d[live[k]], dk, d[live[k]])) return false;
+            }
+        }
+        return true;
+    }
+
+    virtual void constrain(const Space& _best) {
+        const Eq20Opt& best = static_cast<const Eq20Opt&>(_best);
+        if (!congruent) {
+            rel(*this, c, IRT_LE, best.c.val());
+            return;
+        }
+        std::vector<Mod::ModDomain> d;
+        if (!classes(d)) {
+            fail();
+            return;
+        }
+
+        // cost = sum w_i x_i is congruent to sum w_i off_i modulo the gcd of the w_i mod_i
+        long long M = 0, R = 0;
+        for (int i = 0; i < x.size(); i++) {
+            if (x[i].assigned()) {
+                R += (long long)w[i] * x[i].val();
+            } else {
+                M = std::gcd(M, (long long)w[i] * d[i].mod);
+                R += (long long)w[i] * d[i].off;
+            }
+        }
+        long long bound = (long long)best.c.val() - 1;
+        if (M > 1) {
+            long long r = ((bound - R) % M + M) % M;
+            if (r > 0) rounded++;
+            bound -= r;
+        }
+        rel(*this, c, IRT_LQ, (int)std::max<long long>(bound, Int::Limits::min));
+        if (failed()) return;
+
+        // largest value of its class each term can take below the bound
+        long long rest = 0;
+        for (int i = 0; i < x.size(); i++) rest += std::min((long long)w[i] * x[i].min(), (long long)w[i] * x[i].max());
+        for (int i = 0; i < x.size(); i++) {
+            if (x[i].assigned() || w[i] == 0 || d[i].mod <= 1) continue;
+            const long long slack = bound - (rest - std::min((long long)w[i] * x[i].min(), (long long)w[i] * x[i].max()));
+            if (w[i] > 0) {
+                long long ub = Mod::fdiv(slack, w[i]);
+                if (ub >= x[i].max()) continue;
+                rel(*this, x[i], IRT_LQ, d[i].down((int)std::max<long long>(ub, x[i].min() - 1)));
+            } else {
+                long long lb = Mod::cdiv(slack, w[i]);
+                if (lb <= x[i].min()) continue;
+                rel(*this, x[i], IRT_GQ, d[i].up((int)std::min<long long>(lb, x[i].max() + 1)));
+            }
+            snapped++;
+            if (failed()) return;
+        }
+    }
+
+    virtual void
+        print(std::ostream& os) const {
+        PROFILE_SCOPE(Profile::PRINT);
+        if (Eq20::sink != nullptr && Eq20::sink->active()) {
+            Eq20::sink->push(x);
+            return;
+        }
+        os << "\tx[] = " << x << std::endl
+            << "\tcost = " << c << std::endl;
+    }
+};
+bool Eq20Opt::congruent = true;
+std::atomic<unsigned long int> Eq20Opt::rounded(0);
+std::atomic<unsigned long int> Eq20Opt::snapped(0);
+
+/// Propagator name used in the log file names
+const char* prop_name(int b) {
+    switch (b) {
+    case Eq20::PROP_LINEAR: return "Linear";
+#if ADV_MOD
+    case Eq20::PROP_MODULO_AUTO: return "AutoAdvModulo";
+    default: return "AdvModulo";
 #else
-                            << "_" << (b == Eq20::PROP_LINEAR ? "Linear" : "Modulo")
+    case Eq20::PROP_MODULO_AUTO: return "AutoModulo";
+    default: return "Modulo";
 #endif
-                            << ".txt";
-                        // Out/LOG_<solutions>_<TestType>_<domain increases>_<id>_<propagator>.txt
+    }
+}
+
+/// Append the presolve results and post-time decisions of the last run to its log
+void log_post_stats(const char* filename) {
+    std::ofstream log(filename, std::ios::app);
+    log << "modulo presolve: " << Mod::postStats.folded << "/" << Mod::postStats.merged << "/"
+        << Mod::postStats.divided << "/" << Mod::postStats.decided << std::endl;
+    log << "modulo presolve time: " << Mod::postStats.presolve << " ms" << std::endl;
+    if (Mod::postStats.posts == 0) return;
+    // summed over every equation of the instance
+    const Mod::PostStats& ps = Mod::postStats;
+    log << "modulo posts: " << ps.posts << std::endl
+        << "modulo posted: " << ps.modulo << std::endl
+        << "modulo gcd: " << ps.lattice << "/" << ps.fails << std::endl
+        << "modulo levels: " << ps.useful << "/" << ps.pruning << "/" << ps.levels << std::endl
+        << "modulo payoff: " << ps.payoff() << std::endl;
+}
+
+/// Result of a single search run
+struct RunResult {
+    double runtime = 0;         ///< milliseconds
+    unsigned long int solutions = 0;
+    unsigned long int nodes = 0;
+    unsigned long int failures = 0;
+    unsigned long int propagations = 0;
+    bool stopped = false;       ///< hit the node, fail or time limit
+    int reason = 0;             ///< Driver::CombinedStop reasons when stopped
+};
+
+/// Log line of the limits that stopped a run, in the driver's words
+void log_reason(std::ostream& log, int reason) {
+    if (reason & Driver::CombinedStop::SR_NODE) log << "reason: node limit reached" << std::endl;
+    if (reason & Driver::CombinedStop::SR_FAIL) log << "reason: fail limit reached" << std::endl;
+    if (reason & Driver::CombinedStop::SR_TIME) log << "reason: time limit reached" << std::endl;
+}
+
+/// Run DFS on the current statics without the driver, for harness modes that need the numbers
+RunResult solve(const Options& opt) {
+    RunResult r;
+    auto start = std::chrono::steady_clock::now();
+    Eq20* root = new Eq20(opt);
+    Search::Options so;
+    so.threads = opt.threads();
+    so.c_d = opt.c_d();
+    so.a_d = opt.a_d();
+    Search::Stop* stop = Driver::CombinedStop::create(opt.node(), opt.fail(), opt.time(), false);
+    so.stop = stop;
+    DFS<Eq20> e(root, so);
+    delete root;
+    while (Eq20* s = e.next()) {
+        delete s;
+        if (++r.solutions == opt.solutions()) break;
+    }
+    Search::Statistics st = e.statistics();
+    r.runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    r.nodes = st.node;
+    r.failures = st.fail;
+    r.propagations = st.propagate;
+    r.stopped = e.stopped();
+    if (r.stopped) r.reason = static_cast<Driver::CombinedStop*>(stop)->reason(st, so);
+    delete stop;
+    return r;
+}
+
+/// What an incremental sweep keeps of an equation set between domains
+struct IncrementalState {
+    int lo = 0, hi = -1;                        ///< box searched so far, empty at first
+    std::vector<std::vector<int>> solutions;    ///< found in it, up to the requested number
+    std::vector<Mod::Carry> eqs;                ///< classes and Modulo memo per equation, any box
+};
+
+/// Print a solution that was found in an earlier box, as Eq20::print would
+void print_values(std::ostream& os, const std::vector<int>& v) {
+    if (Eq20::sink != nullptr && Eq20::sink->active()) {
+        Eq20::sink->push_row(v.data());
+        return;
+    }
+    os << "\tx[] = {";
+    for (size_t i = 0; i < v.size(); i++) os << (i > 0 ? ", " : "") << v[i];
+    os << "}" << std::endl;
+}
+
+// Incremental run on the current statics
+//   the solutions of the smaller box in st are still solutions, only the added region is searched.
+//   It is split into disjoint boxes, box i keeps x_0..x_i-1 in the old box and puts x_i outside of it,
+//   each searched on a clone of one root. The root posts the equations with the classes and memo
+//   st carries from the earlier boxes. Solutions go where the driver puts them and the log is written
+//   in the driver's format. st is updated to the current box, false if the search was stopped and st
+//   can not be continued.
+bool run_incremental(const Options& opt, const std::string& filename, IncrementalState& st) {
+    auto start = std::chrono::steady_clock::now();
+    const unsigned long int limit = opt.solutions();
+    RunResult r;
+    unsigned long int boxes = 0, depth = 0;
+
+    // as the driver, standard output unless a file is given
+    std::ofstream out_file;
+    if (opt.out_file() != nullptr && std::strcmp(opt.out_file(), "-") != 0) out_file.open(opt.out_file());
+    std::ostream& out = out_file.is_open() ? out_file : std::cout;
+
+    // known solutions first
+    std::vector<std::vector<int>> found;
+    for (auto& v : st.solutions) {
+        if (limit != 0 && found.size() == limit) break;
+        print_values(out, v);
+        found.push_back(v);
+    }
+    const unsigned long int reused = found.size();
+
+    Eq20::carry = &st.eqs;
+    Eq20* root = new Eq20(opt);
+    Eq20::carry = nullptr;
+    unsigned long int carried = 0;
+    for (const Mod::Carry& k : st.eqs) if (k.classes.carried) carried++;
+    if ((limit == 0 || found.size() < limit) && root->status() != SS_FAILED) {
+        Search::Options so;
+        so.threads = opt.threads();
+        so.c_d = opt.c_d();
+        so.a_d = opt.a_d();
+        // one time budget for all boxes, the node and fail limits hold per box as they count per engine
+        Search::Stop* stop = Driver::CombinedStop::create(opt.node(), opt.fail(), opt.time(), false);
+        so.stop = stop;
+        const bool fresh = st.lo > st.hi;
+        const int n = fresh ? 1 : (int)a_is[0].size() - 1;
+        for (int i = 0; i < n && !r.stopped && (limit == 0 || found.size() < limit); i++) {
+            Eq20* s = static_cast<Eq20*>(root->clone());
+            if (!fresh) s->added(i, st.lo, st.hi);
+            boxes++;
+            DFS<Eq20> e(s, so);
+            delete s;
+            while (Eq20* t = e.next()) {
+                t->print(out);
+                found.push_back(t->values());
+                delete t;
+                if (found.size() == limit) break;
+            }
+            Search::Statistics es = e.statistics();
+            r.nodes += es.node;
+            r.failures += es.fail;
+            r.propagations += es.propagate;
+            depth = std::max<unsigned long int>(depth, es.depth);
+            r.stopped = e.stopped();
+            if (r.stopped) r.reason = static_cast<Driver::CombinedStop*>(stop)->reason(es, so);
+        }
+        delete stop;
+    }
+    delete root;
+    r.solutions = found.size();
+    r.runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::ofstream log(filename, std::ios::trunc);
+    log << std::endl << "Summary" << std::endl
+        << "\truntime:      " << std::fixed << std::setprecision(3) << r.runtime / 1000 << " (" << r.runtime << " ms)" << std::endl
+        << std::defaultfloat
+        << "\tsolutions:    " << r.solutions << std::endl
+        << "\tpropagations: " << r.propagations << std::endl
+        << "\tnodes:        " << r.nodes << std::endl
+        << "\tfailures:     " << r.failures << std::endl
+        << "\tpeak depth:   " << depth << std::endl;
+    if (r.stopped) log_reason(log, r.reason);
+    log << "incremental boxes: " << boxes << std::endl
+        << "incremental reused: " << reused << std::endl
+        << "incremental carried: " << carried << std::endl;
+
+    if (r.stopped) return false;
+    st.lo = domains[0];
+    st.hi = domains[1];
+    st.solutions = std::move(found);
+    return true;
+}
+
+/// Exact count of the current statics, by dynamic programming or by a full search when that does not fit
+Count::Result count_solutions(ModOptions& opt, int group) {
+    // the same instance comes back for every solution limit and propagation of the sweep, the count
+    // does not depend on either, whichever way it was found
+    static std::map<std::pair<int, int>, Count::Result> counted;
+    const auto key = std::make_pair(group, next_id);
+    auto it = counted.find(key);
+    if (it != counted.end()) return it->second;
+
+    Count::Result r = Count::count(a_is, domains[0], domains[1], opt.count_memory());
+    if (r.exact) return counted[key] = r;
+
+    // fall back to enumerating every solution
+    const unsigned int cap = opt.solutions();
+    opt.solutions(0);
+    RunResult s = solve(opt);
+    opt.solutions(cap);
+    r.method = "search";
+    r.exact = !s.stopped;
+    r.solutions = s.solutions;
+    r.runtime = s.runtime;
+    return counted[key] = r;
+}
+
+/// Append an exact count to a run log
+void log_count(const char* filename, const Count::Result& r) {
+    std::ofstream log(filename, std::ios::app);
+    if (r.exact) log << "exact solutions: " << r.solutions << std::endl;
+    log << "count method: " << r.method << std::endl
+        << "count runtime: " << r.runtime << " ms" << std::endl;
+}
+
+/// Compile-time variant of the propagators
+std::string variant(void) {
+    std::stringstream v;
+    v << "DEBUG=" << DEBUG << " SHORT_CIRCUIT=" << SHORT_CIRCUIT << " LIMIT_DOMAIN=" << LIMIT_DOMAIN
+        << " ADV_MOD=" << ADV_MOD << " DBL_BOUND=" << DBL_BOUND << " ADAPTIVE=" << ADAPTIVE
+        << " ADAPT_PATIENCE=" << ADAPT_PATIENCE << " ADAPT_MAX=" << ADAPT_MAX << " MEMO=" << MEMO
+        << " MEMO_LIMIT=" << MEMO_LIMIT << " PRESOLVE=" << PRESOLVE << " DOM_TYPE=" << DOM_TYPE
+        << " WIDE_TERMS=" << WIDE_TERMS << " REACH_LIMIT=" << REACH_LIMIT;
+    return v.str();
+}
 
-                        opt.log_file(filename.str().c_str());
+/// Result cache key of a run on the current statics
+ResultCache::Key run_key(const ModOptions& opt, int b) {
+    static const std::string build = std::string(MODULO_BUILD_ID) + " " + variant();
+    ResultCache::Key k;
+    k.add(build);
+    k.add((long long)domains[0]).add((long long)domains[1]).add((long long)a_is.size());
+    for (auto const& row : a_is) k.add(row);
+    k.add((long long)b).add((long long)opt.solutions()).add((long long)opt.time())
+        .add((long long)opt.node()).add((long long)opt.fail())
+        .add(opt.threads()).add((long long)opt.recompute()).add((long long)opt.incremental())
+        .add((long long)opt.ipl()).add((long long)opt.counting()).add((long long)opt.count_memory())
+        .add((long long)opt.sink()).add((long long)opt.dedupe()).add((long long)opt.profile())
+        .add((long long)opt.optimise()).add((long long)opt.objective()).add((long long)opt.seed());
+    // the adaptive distances depend on the runs before, the option stands for them
+    if (!opt.recompute()) k.add((long long)opt.c_d()).add((long long)opt.a_d());
+    return k;
+}
+
+/// Append what the sink took to a run log
+void log_sink(const char* filename, const Sink::Sink& sink) {
+    std::ofstream log(filename, std::ios::app);
+    log << "sink solutions: " << sink.solutions << std::endl
+        << "sink unique: " << sink.unique << std::endl
+        << "sink batches: " << sink.batches << std::endl;
+}
+
+/// Append the phase times of a run to its log and to the folded stacks file
+void log_profile(const ModOptions& opt, const std::string& filename, double wall, double cpu) {
+    std::ofstream log(filename, std::ios::app);
+    double rest_wall = wall, rest_cpu = cpu;
+    for (int p = 0; p < Profile::PHASES; p++) {
+        const Profile::Phase ph = (Profile::Phase)p;
+        rest_wall -= Profile::wall(ph);
+        rest_cpu -= Profile::cpu(ph);
+        log << "profile " << Profile::names[p] << ": " << Profile::wall(ph) << " ms wall, "
+            << Profile::cpu(ph) << " ms cpu, " << Profile::state.phase[p].calls << " calls" << std::endl;
+    }
+    // recomputation apart from its commits, and the engine
+    log << "profile other: " << std::max(rest_wall, 0.0) << " ms wall, " << std::max(rest_cpu, 0.0) << " ms cpu" << std::endl
+        << "profile total: " << wall << " ms wall, " << cpu << " ms cpu" << std::endl;
+
+    if (opt.profile_file() == NULL) return;
+    // <run>;<phase>;<part> <us>, the log name without directory and extension is the root frame
+    std::string run = filename.substr(filename.find_last_of("/\\") + 1);
+    run = run.substr(0, run.find_last_of('.'));
+    std::ofstream folded(opt.profile_file(), std::ios::app);
+    for (int p = 0; p < Profile::PHASES; p++) {
+        std::string frames = Profile::names[p];
+        std::replace(frames.begin(), frames.end(), ' ', ';');
+        long long us = (long long)(1000 * Profile::wall((Profile::Phase)p));
+        if (us > 0) folded << run << ";" << frames << " " << us << std::endl;
+    }
+    if (rest_wall > 0) folded << run << ";other " << (long long)(1000 * rest_wall) << std::endl;
+}
+
+/// Clone and recomputation cost on the root of the coming run
+template <class S>
+Recompute::Estimate probe_root(const Options& opt) {
+    S* root = new S(opt);
+    const Recompute::Estimate e = Recompute::probe(root);
+    delete root;
+    return e;
+}
 
-                        opt.propagation(b);
-                        Script::run<Eq20, DFS, Options>(opt);
-                    }
+/// Instances sharing recomputation costs: suite, shape, domain width in bits and propagation
+std::string recompute_family(char suite, const Corpus::InstanceView& inst, int b) {
+    int bits = 0;
+    for (long long w = (long long)inst.dom_max() - inst.dom_min(); w > 0; w >>= 1) bits++;
+    std::stringstream f;
+    f << suite << "_" << inst.eqs() << "_" << inst.terms() << "_" << bits << "_" << b;
+    return f.str();
+}
 
-                    a_is.clear();
+/// Append the chosen distances and the smoothed costs behind them to a run log
+void log_recompute(const char* filename, const Options& opt, const Recompute::Estimate& e) {
+    std::ofstream log(filename, std::ios::app);
+    log << "recompute c_d: " << opt.c_d() << std::endl
+        << "recompute a_d: " << opt.a_d() << std::endl
+        << "recompute clone: " << e.clone << " ns" << std::endl
+        << "recompute step: " << e.step << " ns" << std::endl;
+}
+
+void run_tests(ModOptions& opt, const Corpus::Reader& corpus, ResultCache::Cache& cache,
+    Recompute::Controller& recompute) {
+    const char suite = corpus.suite();
+    Sink::Sink sink((Sink::Mode)opt.sink(), opt.sink_batch(), opt.dedupe());
+    Eq20::sink = &sink;
+    if (sink.type() == Sink::BINARY) std::filesystem::create_directories("Solutions");
+    // last box and solutions of every equation set, for -incremental
+    std::map<std::vector<std::vector<int>>, IncrementalState> grown;
+    // stream the instances straight out of the mapping
+    for (size_t i = 0; i < corpus.size(); i++) {
+        Corpus::InstanceView inst = corpus[i];
+
+        domains[0] = inst.dom_min();
+        domains[1] = inst.dom_max();
+        next_id = inst.id();
+        for (int e = 0; e < inst.eqs(); e++) {
+            a_is.emplace_back(inst.row(e), inst.row(e) + inst.terms() + 1);
+        }
+        if (opt.optimise() != ModOptions::OPT_OFF) {
+            std::mt19937 rng(opt.seed() + next_id);
+            std::uniform_int_distribution<int> wd(1, 10);
+            weights.assign(inst.terms(), 1);
+            if (opt.objective() == ModOptions::OBJ_WEIGHTED)
+                for (int& wi : weights) wi = wd(rng);
+        }
+        // LinearBAB, ModuloCBAB, ... for the optimisation runs
+        const char* opt_name = opt.optimise() == ModOptions::OPT_PLAIN ? "BAB"
+            : opt.optimise() == ModOptions::OPT_CONGRUENCE ? "CBAB" : "";
+
+        const int prop = opt.propagation();
+        for (auto const b : { prop }) {
+        //for (auto const b : { Eq20::PROP_MODULO, Eq20::PROP_LINEAR }) {
+        //for (auto const b : { Eq20::PROP_LINEAR, Eq20::PROP_MODULO }) {
+
+            // get the output filename
+            std::stringstream filename;
+            filename << "Out/LOG"
+                << "_" << opt.solutions()
+                << "_" << suite
+                << "_" << inst.group()
+                << "_" << next_id
+                << "_" << prop_name(b) << opt_name
+                << ".txt";
+            // Out/LOG_<solutions>_<TestType>_<domain increases>_<id>_<propagator>.txt
+
+            opt.log_file(filename.str().c_str());
+
+            // already done by an earlier sweep
+            const ResultCache::Key key = run_key(opt, b);
+            if (cache.restore(key, filename.str())) {
+                // nothing to continue from
+                grown.erase(a_is);
+                continue;
+            }
+
+            opt.propagation(b);
+            Recompute::Estimate costs;
+            if (opt.recompute()) {
+                // probe before the statistics are reset, the probe posts the model once
+                const std::string fam = recompute_family(suite, inst, b);
+                costs = recompute.update(fam, opt.optimise() == ModOptions::OPT_OFF
+                    ? probe_root<Eq20>(opt) : probe_root<Eq20Opt>(opt));
+                unsigned int c_d, a_d;
+                recompute.distances(fam, c_d, a_d);
+                opt.c_d(c_d);
+                opt.a_d(a_d);
+            }
+            Mod::postStats = Mod::PostStats();
+            if (sink.active()) {
+                // Solutions/SOL_<solutions>_<TestType>_<domain increases>_<id>_<propagator>.bin
+                std::stringstream solfile;
+                solfile << "Solutions/SOL_" << opt.solutions() << "_" << suite << "_" << inst.group()
+                    << "_" << next_id << "_" << prop_name(b) << opt_name << ".bin";
+                sink.open(inst.terms(), solfile.str());
+            }
+            Profile::reset(opt.profile(), opt.profile_sample());
+            auto wall_start = std::chrono::steady_clock::now();
+            std::clock_t cpu_start = std::clock();
+            if (opt.optimise() == ModOptions::OPT_OFF && opt.incremental()) {
+                IncrementalState& st = grown[a_is];
+                // a box that does not contain the last one starts over, the carried classes hold for any box
+                if (st.lo < domains[0] || st.hi > domains[1]) {
+                    st.lo = 0;
+                    st.hi = -1;
+                    st.solutions.clear();
                 }
+                if (!run_incremental(opt, filename.str(), st)) grown.erase(a_is);
+            } else if (opt.optimise() == ModOptions::OPT_OFF) {
+                Script::run<Eq20, DFS, Options>(opt);
+            } else {
+                Eq20Opt::congruent = opt.optimise() == ModOptions::OPT_CONGRUENCE;
+                Eq20Opt::rounded = 0;
+                Eq20Opt::snapped = 0;
+                Script::run<Eq20Opt, BAB, Options>(opt);
+            }
+            const double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+            const double cpu = 1000.0 * (std::clock() - cpu_start) / CLOCKS_PER_SEC;
+            Profile::state.enabled = false;
+            if (opt.profile()) log_profile(opt, filename.str(), wall, cpu);
+            if (sink.active()) {
+                sink.close();
+                log_sink(filename.str().c_str(), sink);
+            }
+            if (b != Eq20::PROP_LINEAR) log_post_stats(filename.str().c_str());
+            if (opt.recompute()) log_recompute(filename.str().c_str(), opt, costs);
+            if (opt.optimise() == ModOptions::OPT_CONGRUENCE) {
+                std::ofstream log(filename.str(), std::ios::app);
+                log << "bab rounded: " << Eq20Opt::rounded.load() << std::endl
+                    << "bab snapped: " << Eq20Opt::snapped.load() << std::endl;
+            }
+            if (opt.counting()) log_count(filename.str().c_str(), count_solutions(opt, inst.group()));
+            cache.store(key, filename.str());
+        }
+
+        a_is.clear();
+    }
+    Eq20::sink = nullptr;
+}
+
+// Regression benchmark
+//   record:  run the first instances of the corpus several times per propagation and store every run
+//   compare: run the same set and compare with the stored baseline, the return value is non-zero
+//            when runtime regressed beyond the threshold or search effort grew
+using RegressKey = std::tuple<char, int, int, int>; // suite, group, id, propagation
 
-                next_id++;
-                break;
+std::map<RegressKey, std::vector<RunResult>> regress_runs(Options& opt, const Corpus::Reader& corpus,
+    unsigned int instances, unsigned int runs) {
+    std::map<RegressKey, std::vector<RunResult>> out;
+    for (size_t i = 0; i < corpus.size() && i < instances; i++) {
+        Corpus::InstanceView inst = corpus[i];
+        domains[0] = inst.dom_min();
+        domains[1] = inst.dom_max();
+        next_id = inst.id();
+        for (int e = 0; e < inst.eqs(); e++) {
+            a_is.emplace_back(inst.row(e), inst.row(e) + inst.terms() + 1);
+        }
+        for (auto const b : { Eq20::PROP_LINEAR, Eq20::PROP_MODULO, Eq20::PROP_MODULO_AUTO }) {
+            opt.propagation(b);
+            auto& v = out[RegressKey(corpus.suite(), inst.group(), inst.id(), b)];
+            for (unsigned int r = 0; r < runs; r++) v.push_back(solve(opt));
+        }
+        a_is.clear();
+    }
+    return out;
+}
+
+int run_regression(ModOptions& opt, const Corpus::Reader& corpus) {
+    auto now = regress_runs(opt, corpus, opt.regress_instances(), opt.runs());
+
+    if (opt.regress() == ModOptions::REGRESS_RECORD) {
+        // kept out of Out/, where the scraper only expects run logs
+        const std::filesystem::path dir = std::filesystem::path(opt.baseline()).parent_path();
+        if (!dir.empty()) std::filesystem::create_directories(dir);
+        std::ofstream out(opt.baseline());
+        out << "suite,group,id,propagation,runtime,solutions,nodes,failures,propagations,stopped" << std::endl;
+        for (auto const& kv : now) {
+            for (auto const& r : kv.second) {
+                out << std::get<0>(kv.first) << "," << std::get<1>(kv.first) << "," << std::get<2>(kv.first)
+                    << "," << std::get<3>(kv.first) << "," << r.runtime << "," << r.solutions
+                    << "," << r.nodes << "," << r.failures << "," << r.propagations << "," << r.stopped << std::endl;
             }
         }
+        std::cout << "baseline of " << now.size() << " configurations written to " << opt.baseline() << std::endl;
+        return 0;
+    }
+
+    // read the baseline back
+    std::map<RegressKey, std::vector<RunResult>> base;
+    std::ifstream in(opt.baseline());
+    if (!in.good()) {
+        std::cerr << "cannot read baseline " << opt.baseline() << std::endl;
+        return 2;
+    }
+    std::string line;
+    std::getline(in, line);
+    while (std::getline(in, line)) {
+        char suite, sep;
+        int group, id, b, stopped;
+        RunResult r;
+        std::stringstream ls(line);
+        ls >> suite >> sep >> group >> sep >> id >> sep >> b >> sep >> r.runtime >> sep >> r.solutions
+            >> sep >> r.nodes >> sep >> r.failures >> sep >> r.propagations >> sep >> stopped;
+        r.stopped = stopped != 0;
+        base[RegressKey(suite, group, id, b)].push_back(r);
+    }
+
+    // runtimes below this are timer noise
+    const double floor_ms = 0.01;
+    std::mt19937 rng(1000);
+    int regressions = 0;
+    for (auto const& kv : now) {
+        auto it = base.find(kv.first);
+        if (it == base.end()) continue;
+        std::vector<double> tb, tn;
+        for (auto const& r : it->second) tb.push_back(r.runtime + floor_ms);
+        for (auto const& r : kv.second) tn.push_back(r.runtime + floor_ms);
+        auto ci = Stats::bootstrap_ratio(tb, tn, rng);
+
+        // search is deterministic, so the effort has to match exactly
+        const RunResult& rb = it->second.front();
+        const RunResult& rn = kv.second.front();
+        bool effort = !rb.stopped && !rn.stopped
+            && (rn.nodes > rb.nodes || rn.propagations > rb.propagations || rn.solutions != rb.solutions);
+        bool slower = ci.first > 1 + opt.threshold();
+
+        if (slower || effort || rn.nodes != rb.nodes || rn.propagations != rb.propagations) {
+            std::cout << std::get<0>(kv.first) << "_" << std::get<1>(kv.first) << "_" << std::get<2>(kv.first)
+                << "_" << prop_name(std::get<3>(kv.first))
+                << ": median " << Stats::median(tb) << " -> " << Stats::median(tn) << " ms"
+                << ", ratio CI [" << ci.first << ", " << ci.second << "]"
+                << ", nodes " << rb.nodes << " -> " << rn.nodes
+                << ", propagations " << rb.propagations << " -> " << rn.propagations
+                << ((slower || effort) ? "  REGRESSION" : "") << std::endl;
+        }
+        if (slower || effort) regressions++;
     }
+    std::cout << regressions << " regressions in " << now.size() << " configurations" << std::endl;
+    return regressions > 0 ? 1 : 0;
+}
+
+// Batched right hand sides
+//   every equation of the corpus keeps its coefficients and box and is solved for -batch right hand
+//   sides, its own first and then values drawn uniformly from the sums of the box, through one
+//   Batch::Solver. Logs go to Batch/, apart from the sweep logs the scraper reads.
+void run_batches(const ModOptions& opt, const Corpus::Reader& corpus) {
+    std::filesystem::create_directories("Batch");
+    const int prop = opt.propagation();
+    const Batch::Post post = prop == Eq20::PROP_LINEAR ? Batch::LINEAR
+        : prop == Eq20::PROP_MODULO_AUTO ? Batch::AUTO : Batch::MODULO;
+    Search::Options so;
+    so.threads = opt.threads();
+    so.c_d = opt.c_d();
+    so.a_d = opt.a_d();
+    for (size_t i = 0; i < corpus.size(); i++) {
+        Corpus::InstanceView inst = corpus[i];
+        for (int e = 0; e < inst.eqs(); e++) {
+            const int32_t* row = inst.row(e);
+            IntArgs a(inst.terms(), row + 1);
+            auto start = std::chrono::steady_clock::now();
+            Batch::Solver solver(a, inst.dom_min(), inst.dom_max(), post, opt.ipl(), so, opt.time(), opt.solutions());
+
+            long long smin = 0, smax = 0;
+            for (int k = 0; k < a.size(); k++) {
+                smin += std::min((long long)a[k] * inst.dom_min(), (long long)a[k] * inst.dom_max());
+                smax += std::max((long long)a[k] * inst.dom_min(), (long long)a[k] * inst.dom_max());
+            }
+            std::mt19937 rng(opt.seed() + inst.id() + e);
+            std::uniform_int_distribution<long long> rd(smin, smax);
+            unsigned long int stopped = 0;
+            for (unsigned int k = 0; k < opt.batch(); k++) {
+                const long long c = k == 0 ? row[0] : rd(rng);
+                if (solver.solve(c).stopped) stopped++;
+            }
+            const double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            // Batch/BATCH_<solutions>_<TestType>_<domain increases>_<id>_<equation>_<propagator>.txt
+            std::stringstream filename;
+            filename << "Batch/BATCH_" << opt.solutions() << "_" << corpus.suite() << "_" << inst.group()
+                << "_" << inst.id() << "_" << e << "_" << prop_name(prop) << ".txt";
+            std::ofstream log(filename.str());
+            log << "batch rhs: " << opt.batch() << std::endl
+                << "batch post: " << (solver.modulo ? "modulo" : "linear") << std::endl
+                << "batch feasible: " << solver.feasible << std::endl
+                << "batch stopped: " << stopped << std::endl
+                << "batch setup: " << solver.setup << " us" << std::endl;
+            for (int v = 0; v < Batch::VERDICTS; v++) {
+                log << "batch " << Batch::names[v] << ": " << solver.count[v] << ", "
+                    << (solver.count[v] > 0 ? solver.time[v] / solver.count[v] : 0) << " us each" << std::endl;
+            }
+            log << "runtime: " << wall << " ms" << std::endl;
+        }
+    }
+}
+
+// does an existing corpus hold the suite and parameters asked for
+bool corpus_matches(const std::string& filename, char tag, uint32_t seed, uint32_t size, uint32_t count) {
+    try {
+        Corpus::Reader r(filename);
+        const Corpus::Header& h = r.header();
+        return r.suite() == tag && h.seed == seed && h.size == size && h.count == count
+            && h.generator == Generators::VERSION;
+    } catch (const std::exception&) {
+        // older version or damaged
+        return false;
+    }
+}
+
+// get the corpus file, generating it from a test suite if it does not exist yet or was generated
+// with other parameters. Corpora live in Corpus/, apart from the logs the scraper reads.
+std::string corpus_file(const ModOptions& opt) {
+    const bool legacy = opt.suite() == BASIC || opt.suite() == XOR || opt.suite() == RANDOM;
+    const char tag = opt.suite() == BASIC ? Corpus::SUITE_BASIC
+        : opt.suite() == XOR ? Corpus::SUITE_XOR
+        : opt.suite() == RANDOM ? Corpus::SUITE_RANDOM
+        : Generators::suite_tag(opt.suite());
+    // the hard-coded suites take no parameters
+    const uint32_t seed = legacy ? 0 : opt.seed();
+    const uint32_t size = legacy ? 0 : opt.size();
+    const uint32_t count = legacy ? 0 : opt.instances();
+
+    std::stringstream filename;
+    if (opt.corpus() != NULL) {
+        // an explicit corpus is used as it is
+        filename << opt.corpus();
+        if (std::ifstream(filename.str()).good()) return filename.str();
+    } else if (legacy) {
+        filename << "Corpus/" << tag << ".modc";
+    } else {
+        // Corpus/<TestType>_<seed>_<size>_<instances>.modc
+        filename << "Corpus/" << tag << "_" << seed << "_" << size << "_" << count << ".modc";
+    }
+
+    if (!corpus_matches(filename.str(), tag, seed, size, count)) {
+        const std::filesystem::path dir = std::filesystem::path(filename.str()).parent_path();
+        if (!dir.empty()) std::filesystem::create_directories(dir);
+        Corpus::Writer w(filename.str(), tag);
+        w.params(seed, size, count, Generators::VERSION);
+        if (legacy) {
+            Corpus::write_tests(w, generate_tests(opt.suite(), 250));
+        } else {
+            Generators::write_family(w, opt.suite(), opt.seed(), opt.instances(), opt.size());
+        }
+        w.close();
+    }
+    return filename.str();
 }
 
 /** \brief Main-function
@@ -180,14 +1108,49 @@ void run_tests(Options& opt) {
  */
 int
 main(int argc, char* argv[]) {
-    for (int i = 1; i <= 1000; i <<= 2) {
-            Options opt("Eq20");
-            opt.time(10000); // 10 seconds timeout
-            opt.solutions(i);
-            opt.iterations(1000);
-            opt.parse(argc, argv);
-            run_tests(opt);
+    ModOptions opt("Eq20");
+    opt.propagation(Eq20::PROP_MODULO);
+    opt.propagation(Eq20::PROP_LINEAR, "linear");
+    opt.propagation(Eq20::PROP_MODULO, "modulo");
+    opt.propagation(Eq20::PROP_MODULO_AUTO, "modulo-auto");
+    opt.time(10000); // 10 seconds timeout
+    opt.iterations(1000);
+    // a -solutions on the command line replaces the sweep over solution counts
+    const unsigned int SWEEP = UINT_MAX;
+    opt.solutions(SWEEP);
+    opt.parse(argc, argv);
+    const bool sweep = opt.solutions() == SWEEP;
+    if (sweep) opt.solutions(1);
+    if (opt.size() < (unsigned int)Generators::min_size(opt.suite())) {
+        std::cerr << "-size " << opt.size() << " is too small for this suite, at least "
+            << Generators::min_size(opt.suite()) << " needed" << std::endl;
+        return 1;
+    }
+    // the corpus is written once and mapped for every pass
+    Corpus::Reader corpus(corpus_file(opt));
+    if (opt.regress() != ModOptions::REGRESS_OFF)
+        return run_regression(opt, corpus);
+    if (opt.batch() > 0) {
+        run_batches(opt, corpus);
+        return 0;
+    }
+    // a hit only restores the run log, runs writing solution files or profiles are not cached
+    const bool artefacts = opt.sink() == Sink::BINARY || opt.profile();
+    if (opt.cache() != NULL && artefacts)
+        std::cerr << "result cache disabled: -sink binary and -profile write more than the run log" << std::endl;
+    ResultCache::Cache cache(artefacts ? NULL : opt.cache());
+    // kept over all passes, the estimates carry from one solution count to the next
+    Recompute::Controller recompute;
+    if (!sweep) {
+        run_tests(opt, corpus, cache, recompute);
+    } else {
+        for (int i = 1; i <= 1000; i <<= 2) {
+                opt.solutions(i);
+                run_tests(opt, corpus, cache, recompute);
+        }
     }
+    if (cache.enabled())
+        std::cout << "result cache: " << cache.hits << " runs reused, " << cache.stored << " stored" << std::endl;
     return 0;
 }
 
@@ -0,0 +1,226 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <gecode/int.hh>
+#include <gecode/search.hh>
+
+#include <chrono>
+#include <numeric>
+#include <vector>
+
+// expects modulo(), Mod::analyse(), Mod::reach_set() and Mod::ModDomain from modulo_propogator.hpp
+
+// Batched right hand sides, a x = c for one coefficient vector and box and many c
+//   everything that does not depend on c is done once: the gcd, the modulus and Bezout inverse of
+//   every term's class, the set of reachable sums (if small enough) and a root space with c as a
+//   variable, propagated once with the post-time analysis. A right hand side is then rejected
+//   by gcd, range, the class of a term or reachability in O(n) without a space, decided directly
+//   when it has a single solution, and otherwise searched on a clone of the root with c assigned
+//   and the bounds snapped to the classes.
+namespace Batch {
+    enum Post {
+        LINEAR,
+        MODULO,
+        AUTO
+    };
+
+    enum Verdict {
+        INFEASIBLE,     ///< the root failed, no c has a solution in the box
+        CONGRUENCE,     ///< gcd does not divide c
+        RANGE,          ///< c outside the sums of the box
+        CLASS,          ///< the class of a term misses the box
+        REACH,          ///< not a reachable sum
+        TRIVIAL,        ///< a single solution, found without search
+        SEARCH,         ///< searched on a clone of the root
+        VERDICTS
+    };
+    static const char* const names[VERDICTS] = {
+        "infeasible", "congruence", "range", "class", "reach", "trivial", "search"
+    };
+
+    struct Result {
+        Verdict verdict = SEARCH;
+        unsigned long int solutions = 0;
+        bool stopped = false;       ///< search hit its stop object
+        double latency = 0;         ///< us
+    };
+
+    // sum a x = rhs over the box, rhs a variable so the root serves every c
+    //   AUTO decides on the analysis of a x alone, the rhs term with coefficient -1 would make every
+    //   co-gcd 1 and the analysis always choose linear. Modulo prunes once rhs is assigned.
+    class Root : public Space {
+    public:
+        IntVarArray x;
+        IntVar rhs;
+        bool modulo = false;    ///< Modulo was posted
+
+        Root(const IntArgs& a, int lo, int hi, int rlo, int rhi, Post post, IntPropLevel ipl) {
+            x = IntVarArray(*this, a.size(), lo, hi);
+            rhs = IntVar(*this, rlo, rhi);
+            modulo = post == MODULO || (post == AUTO && Mod::analyse(a, x, 0).post);
+            if (modulo) {
+                IntArgs ax(a);
+                IntVarArgs xs(x);
+                ax << -1;
+                xs << rhs;
+                ::modulo(*this, ax, xs, 0, ipl);
+            } else {
+                linear(*this, a, x, IRT_EQ, rhs, ipl);
+            }
+            branch(*this, x, INT_VAR_NONE(), INT_VAL_MIN());
+        }
+        Root(Root& s) : Space(s) {
+            x.update(*this, s.x);
+            rhs.update(*this, s.rhs);
+        }
+        virtual Space* copy(void) {
+            return new Root(*this);
+        }
+    };
+
+    class Solver {
+    protected:
+        std::vector<long long> a;
+        int lo, hi;
+        bool zeros = false;             ///< a zero coefficient, no c has a single solution then
+        long long g = 0;                ///< gcd of a
+        long long smin = 0, smax = 0;   ///< sums of the box
+        std::vector<int> mod;           ///< modulus of the class of x_i, gcd of the others over g
+        std::vector<long long> inv;     ///< inverse of a_i / g modulo mod_i
+        std::vector<uint64_t> reach;    ///< reachable sums minus smin, empty when too big
+        std::vector<Mod::ModDomain> cls; ///< classes of the current c
+        Root* root = nullptr;           ///< nullptr when the box has no solution for any c
+        Search::Options so;
+        unsigned int timeout;           ///< ms per search, 0 for none
+        unsigned long int limit;        ///< solutions per c, 0 for all
+
+        // fill cls for c, false if a class has no value in the box
+        bool classes(long long c) {
+            const long long cg = c / g;
+            for (size_t i = 0; i < a.size(); i++) {
+                if (mod[i] <= 1) {
+                    cls[i] = Mod::ModDomain();
+                    continue;
+                }
+                const long long m = mod[i];
+                long long off = (cg % m + m) % m * inv[i] % m;
+                cls[i] = Mod::ModDomain((int)off, (int)m);
+                if (cls[i].up(lo) > hi) return false;
+            }
+            return true;
+        }
+    public:
+        unsigned long int count[VERDICTS] = {};
+        double time[VERDICTS] = {};     ///< us per verdict
+        unsigned long int feasible = 0;
+        double setup = 0;               ///< us spent in the constructor
+        bool modulo = false;            ///< the root posted Modulo
+
+        Solver(const IntArgs& a0, int _lo, int _hi, Post post, IntPropLevel ipl,
+            const Search::Options& _so, unsigned int _timeout, unsigned long int _limit)
+            : a(a0.begin(), a0.end()), lo(_lo), hi(_hi), so(_so), timeout(_timeout), limit(_limit) {
+            auto start = std::chrono::steady_clock::now();
+            const size_t n = a.size();
+            for (long long ai : a) {
+                g = std::gcd(g, ai);
+                zeros = zeros || ai == 0;
+                smin += ai > 0 ? ai * lo : ai * hi;
+                smax += ai > 0 ? ai * hi : ai * lo;
+            }
+
+            // classes, x_i = c / g * inv_i modulo the gcd of the others
+            mod.assign(n, 1);
+            inv.assign(n, 0);
+            cls.assign(n, Mod::ModDomain());
+            if (g != 0) {
+                std::vector<long long> suf(n + 1, 0);
+                for (size_t i = n; i-- > 0; ) suf[i] = std::gcd(suf[i + 1], a[i] / g);
+                long long pre = 0;
+                for (size_t i = 0; i < n; i++) {
+                    const long long G = std::gcd(pre, suf[i + 1]);
+                    pre = std::gcd(pre, a[i] / g);
+                    if (G <= 1) continue;
+                    int gg, u, v;
+                    std::tie(gg, u, v) = ::extended_gcd(pmod((int)(a[i] / g % G), (int)G), (int)G);
+                    mod[i] = (int)G;
+                    inv[i] = pmod(u, (int)G);
+                }
+            }
+
+            std::vector<long long> w(n, (long long)hi - lo);
+            reach = Mod::reach_set(a, w, smax - smin);
+
+            root = new Root(a0, lo, hi,
+                (int)std::max<long long>(smin, Int::Limits::min), (int)std::min<long long>(smax, Int::Limits::max),
+                post, ipl);
+            modulo = root->modulo;
+            if (root->status() == SS_FAILED) {
+                delete root;
+                root = nullptr;
+            }
+            setup = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        }
+        ~Solver(void) { delete root; }
+
+        Result solve(long long c) {
+            auto start = std::chrono::steady_clock::now();
+            Result r = decide(c);
+            r.latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            count[r.verdict]++;
+            time[r.verdict] += r.latency;
+            if (r.solutions > 0) feasible++;
+            return r;
+        }
+
+    protected:
+        Result decide(long long c) {
+            Result r;
+            if (root == nullptr) {
+                r.verdict = INFEASIBLE;
+                return r;
+            }
+            if (c < smin || c > smax || c < Int::Limits::min || c > Int::Limits::max) {
+                r.verdict = RANGE;
+                return r;
+            }
+            if (g == 0 ? c != 0 : c % g != 0) {
+                r.verdict = CONGRUENCE;
+                return r;
+            }
+            if (g != 0 && !classes(c)) {
+                r.verdict = CLASS;
+                return r;
+            }
+            if (!reach.empty() && !((reach[(c - smin) >> 6] >> ((c - smin) & 63)) & 1)) {
+                r.verdict = REACH;
+                return r;
+            }
+            // every term at its extreme, or the one term
+            if (!zeros && (c == smin || c == smax || a.size() == 1)) {
+                // the checks above put it in the box
+                r.verdict = TRIVIAL;
+                r.solutions = 1;
+                return r;
+            }
+
+            r.verdict = SEARCH;
+            Root* s = static_cast<Root*>(root->clone());
+            rel(*s, s->rhs, IRT_EQ, (int)c);
+            for (size_t i = 0; i < a.size(); i++)
+                if (cls[i].mod > 1) dom(*s, s->x[(int)i], cls[i].up(lo), cls[i].down(hi));
+            Search::Options o = so;
+            Search::TimeStop stop(timeout);
+            if (timeout > 0) o.stop = &stop;
+            DFS<Root> e(s, o);
+            delete s;
+            while (Root* t = e.next()) {
+                delete t;
+                if (++r.solutions == limit) break;
+            }
+            r.stopped = e.stopped();
+            return r;
+        }
+    };
+};
+
+// STATISTICS: example-any
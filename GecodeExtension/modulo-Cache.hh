@@ -0,0 +1,93 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// build identifier folded into every key. The harness is a single translation unit over the
+// header-only propagators, so any change to them recompiles it and the compile time changes
+// the key. Define it to a fixed value (a commit hash) to share a cache between rebuilds.
+#ifndef MODULO_BUILD_ID
+#define MODULO_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+// Content-addressed cache of finished run logs
+//   the key is a hash of everything that decides a run: instance data, propagation, compile-time
+//   variant, options and build id. A hit copies the stored log to the run's log file, so the output
+//   directory ends up the same whether a run was cached or not. Entries are written to a temporary
+//   file and renamed, so an interrupted sweep never leaves a partial entry behind.
+namespace ResultCache {
+    // 64 bit FNV-1a
+    class Key {
+    protected:
+        uint64_t h = 14695981039346656037ull;
+    public:
+        Key& add(const void* p, size_t n) {
+            const unsigned char* b = static_cast<const unsigned char*>(p);
+            for (size_t i = 0; i < n; i++) h = (h ^ b[i]) * 1099511628211ull;
+            return *this;
+        }
+        Key& add(long long v) { return add(&v, sizeof(v)); }
+        Key& add(double v) { return add(&v, sizeof(v)); }
+        Key& add(const std::string& s) {
+            add((long long)s.size());
+            return add(s.data(), s.size());
+        }
+        Key& add(const std::vector<int>& v) {
+            add((long long)v.size());
+            return add(v.data(), v.size() * sizeof(int));
+        }
+        std::string hex(void) const {
+            char buf[17];
+            snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+            return buf;
+        }
+    };
+
+    class Cache {
+    protected:
+        std::string dir;    ///< empty when disabled
+    public:
+        unsigned long int hits = 0;
+        unsigned long int stored = 0;
+
+        Cache(const char* _dir) : dir(_dir != NULL ? _dir : "") {
+            if (enabled()) std::filesystem::create_directories(dir);
+        }
+        bool enabled(void) const { return !dir.empty(); }
+        std::string entry(const Key& k) const { return dir + "/" + k.hex() + ".txt"; }
+
+        // copy a cached log to filename, false on a miss
+        bool restore(const Key& k, const std::string& filename) {
+            if (!enabled()) return false;
+            std::ifstream in(entry(k), std::ios::binary);
+            if (!in.good()) return false;
+            std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+            out << in.rdbuf();
+            hits++;
+            return true;
+        }
+
+        // store the finished log of a run
+        void store(const Key& k, const std::string& filename) {
+            if (!enabled()) return;
+            std::ifstream in(filename, std::ios::binary);
+            if (!in.good()) return;
+            const std::string tmp = entry(k) + ".tmp";
+            {
+                std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+                out << in.rdbuf();
+            }
+            std::error_code ec;
+            std::filesystem::rename(tmp, entry(k), ec);
+            if (!ec) stored++;
+        }
+    };
+};
+
+// STATISTICS: example-any
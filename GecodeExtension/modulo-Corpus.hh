@@ -0,0 +1,373 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// On-disk instance corpus
+//
+// layout (native byte order, every section 8 byte aligned):
+//   Header
+//   coefficient section  int32[]   rows of c, a_0, ..., a_terms-1
+//   record section       Record[]  one per instance, in run order
+//   domain section       Domain[]  distinct domains, indexed by records
+//   group section        Group[]   consecutive records sharing a domain group
+namespace Corpus {
+    const char MAGIC[4] = { 'M', 'O', 'D', 'C' };
+    const uint32_t VERSION = 2;
+
+    // suite tags, match the log file naming
+    const char SUITE_BASIC = 'B';
+    const char SUITE_XOR = 'X';
+    const char SUITE_RANDOM = 'R';
+    const char SUITE_GENERATED = 'G';
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t suite;         ///< suite tag
+        uint32_t instances;     ///< number of records
+        uint32_t domains;       ///< number of domains
+        uint32_t groups;        ///< number of groups
+        uint32_t seed;          ///< generation parameters, checked before a corpus is reused
+        uint32_t size;
+        uint32_t count;
+        uint32_t generator;     ///< version of the generating code
+        uint64_t coeffs;        ///< number of int32 in the coefficient section
+        uint64_t coeff_off;     ///< byte offsets of the sections
+        uint64_t record_off;
+        uint64_t domain_off;
+        uint64_t group_off;
+    };
+
+    struct Record {
+        uint32_t group;         ///< domain group, the old reset count
+        uint32_t id;            ///< id inside the group
+        uint32_t domain;        ///< index into the domain section
+        uint32_t eqs;           ///< equations posted together
+        uint32_t terms;         ///< terms per equation
+        uint32_t pad;
+        uint64_t coeff;         ///< index of the first row in the coefficient section
+    };
+
+    struct Domain {
+        int32_t min;
+        int32_t max;
+    };
+
+    struct Group {
+        uint32_t group;         ///< domain group number
+        uint32_t first;         ///< first record
+        uint32_t count;         ///< number of records
+        uint32_t pad;
+    };
+
+    // in memory instance, used by the writer and the generators
+    struct Instance {
+        int group = 0;
+        int id = 0;
+        int dom_min = 0;
+        int dom_max = 0;
+        // c, a_0, a_1, ...
+        std::vector<std::vector<int>> rows;
+    };
+
+    // view of a single mapped instance, nothing is copied
+    class InstanceView {
+    protected:
+        const Record* rec;
+        const Domain* dom;
+        const int32_t* coeff;
+    public:
+        InstanceView(void) : rec(nullptr), dom(nullptr), coeff(nullptr) {}
+        InstanceView(const Record* _rec, const Domain* _dom, const int32_t* _coeff)
+            : rec(_rec), dom(_dom), coeff(_coeff) {}
+
+        int group(void) const { return rec->group; }
+        int id(void) const { return rec->id; }
+        int eqs(void) const { return rec->eqs; }
+        int terms(void) const { return rec->terms; }
+        int dom_min(void) const { return dom->min; }
+        int dom_max(void) const { return dom->max; }
+        // row e of the instance, c followed by terms() coefficients
+        const int32_t* row(int e) const { return coeff + (size_t)e * (rec->terms + 1); }
+    };
+
+    inline uint64_t align8(uint64_t n) {
+        return (n + 7) & ~(uint64_t)7;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Streaming writer, coefficients go straight to disk, the small sections are written on close
+    class Writer {
+    protected:
+        FILE* f;
+        Header head;
+        std::vector<Record> records;
+        std::vector<Domain> domains;
+        std::vector<Group> groups;
+
+        void put(const void* p, size_t n) {
+            if (fwrite(p, 1, n, f) != n)
+                throw std::runtime_error("Corpus::Writer: write failed");
+        }
+        // 64 bit offsets, long is 32 bit on Windows
+        uint64_t tell(void) {
+#ifdef _WIN32
+            long long pos = _ftelli64(f);
+#else
+            off_t pos = ftello(f);
+#endif
+            if (pos < 0)
+                throw std::runtime_error("Corpus::Writer: tell failed");
+            return (uint64_t)pos;
+        }
+        void seek_start(void) {
+#ifdef _WIN32
+            const int err = _fseeki64(f, 0, SEEK_SET);
+#else
+            const int err = fseeko(f, 0, SEEK_SET);
+#endif
+            if (err != 0)
+                throw std::runtime_error("Corpus::Writer: seek failed");
+        }
+        void pad(void) {
+            static const char zero[8] = {};
+            uint64_t pos = tell();
+            put(zero, align8(pos) - pos);
+        }
+    public:
+        Writer(const std::string& filename, char suite) : f(fopen(filename.c_str(), "wb")), head() {
+            if (f == nullptr)
+                throw std::runtime_error("Corpus::Writer: cannot open " + filename);
+            memcpy(head.magic, MAGIC, sizeof(MAGIC));
+            head.version = VERSION;
+            head.suite = suite;
+            head.coeff_off = align8(sizeof(Header));
+            // placeholder header, rewritten by close
+            put(&head, sizeof(Header));
+            pad();
+        }
+        // an unclosed writer is closed here, errors are dropped, call close() to see them
+        ~Writer(void) {
+            if (f == nullptr) return;
+            try {
+                close();
+            } catch (const std::exception&) {
+                if (f != nullptr) fclose(f);
+                f = nullptr;
+            }
+        }
+
+        // parameters the corpus was generated with, stored in the header
+        void params(uint32_t seed, uint32_t size, uint32_t count, uint32_t generator) {
+            head.seed = seed;
+            head.size = size;
+            head.count = count;
+            head.generator = generator;
+        }
+
+        // append an instance, every row must have the same number of terms
+        void add(const Instance& inst) {
+            if (inst.rows.empty())
+                throw std::runtime_error("Corpus::Writer: instance without equations");
+            if (inst.rows[0].size() < 2)
+                throw std::runtime_error("Corpus::Writer: equation without terms");
+            Record r = {};
+            r.group = inst.group;
+            r.id = inst.id;
+            r.eqs = (uint32_t)inst.rows.size();
+            r.terms = (uint32_t)inst.rows[0].size() - 1;
+            r.coeff = head.coeffs;
+
+            // share consecutive identical domains
+            if (domains.empty() || domains.back().min != inst.dom_min || domains.back().max != inst.dom_max)
+                domains.push_back({ inst.dom_min, inst.dom_max });
+            r.domain = (uint32_t)domains.size() - 1;
+
+            // group consecutive records
+            if (groups.empty() || groups.back().group != r.group)
+                groups.push_back({ r.group, (uint32_t)records.size(), 0, 0 });
+            groups.back().count++;
+
+            for (auto const& row : inst.rows) {
+                if (row.size() != r.terms + 1)
+                    throw std::runtime_error("Corpus::Writer: ragged equation group");
+                std::vector<int32_t> out(row.begin(), row.end());
+                put(out.data(), out.size() * sizeof(int32_t));
+                head.coeffs += out.size();
+            }
+            records.push_back(r);
+        }
+
+        void close(void) {
+            pad();
+            head.record_off = tell();
+            put(records.data(), records.size() * sizeof(Record));
+            head.domain_off = tell();
+            put(domains.data(), domains.size() * sizeof(Domain));
+            pad();
+            head.group_off = tell();
+            put(groups.data(), groups.size() * sizeof(Group));
+            head.instances = (uint32_t)records.size();
+            head.domains = (uint32_t)domains.size();
+            head.groups = (uint32_t)groups.size();
+            seek_start();
+            put(&head, sizeof(Header));
+            const int err = fclose(f);
+            f = nullptr;
+            if (err != 0)
+                throw std::runtime_error("Corpus::Writer: close failed");
+        }
+    };
+
+    // converts a generate_tests stream into corpus records
+    //   size 0 -> new domain group, size 1 -> equations per post, size 2 -> domain
+    void write_tests(Writer& w, const std::vector<std::vector<int>>& tests) {
+        Instance inst;
+        int eq_num = 1;
+        int next_id = 0;
+        for (auto const& test : tests) {
+            switch (test.size()) {
+            case 0:
+                next_id = 0;
+                inst.group++;
+                break;
+            case 1:
+                eq_num = test[0];
+                break;
+            case 2:
+                inst.dom_min = test[0];
+                inst.dom_max = test[1];
+                break;
+            default:
+                inst.rows.push_back(test);
+                if ((int)inst.rows.size() == eq_num) {
+                    inst.id = next_id;
+                    w.add(inst);
+                    inst.rows.clear();
+                }
+                next_id++;
+                break;
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Memory mapped reader
+    class Reader {
+    protected:
+        const char* base;
+        size_t len;
+        const Header* head;
+#ifdef _WIN32
+        HANDLE file;
+        HANDLE mapping;
+#endif
+        void check(bool ok, const std::string& what) {
+            if (!ok) {
+                unmap();
+                throw std::runtime_error("Corpus::Reader: " + what);
+            }
+        }
+        void unmap(void) {
+            if (base == nullptr) return;
+#ifdef _WIN32
+            UnmapViewOfFile(base);
+            CloseHandle(mapping);
+            CloseHandle(file);
+#else
+            munmap((void*)base, len);
+#endif
+            base = nullptr;
+        }
+    public:
+        Reader(const std::string& filename) : base(nullptr), len(0), head(nullptr) {
+#ifdef _WIN32
+            file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (file == INVALID_HANDLE_VALUE)
+                throw std::runtime_error("Corpus::Reader: cannot open " + filename);
+            LARGE_INTEGER size;
+            GetFileSizeEx(file, &size);
+            len = (size_t)size.QuadPart;
+            mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+            base = mapping == NULL ? nullptr : (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (base == nullptr) {
+                if (mapping != NULL) CloseHandle(mapping);
+                CloseHandle(file);
+                throw std::runtime_error("Corpus::Reader: cannot map " + filename);
+            }
+#else
+            int fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Corpus::Reader: cannot open " + filename);
+            struct stat st;
+            fstat(fd, &st);
+            len = st.st_size;
+            void* p = len < sizeof(Header) ? MAP_FAILED : mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (p == MAP_FAILED)
+                throw std::runtime_error("Corpus::Reader: cannot map " + filename);
+            // records are read front to back
+            madvise(p, len, MADV_SEQUENTIAL);
+            base = (const char*)p;
+#endif
+            head = (const Header*)base;
+            check(len >= sizeof(Header) && memcmp(head->magic, MAGIC, sizeof(MAGIC)) == 0, "bad magic in " + filename);
+            check(head->version == VERSION, "unsupported version in " + filename);
+            check(head->coeff_off + head->coeffs * sizeof(int32_t) <= len
+                && head->record_off + (uint64_t)head->instances * sizeof(Record) <= len
+                && head->domain_off + (uint64_t)head->domains * sizeof(Domain) <= len
+                && head->group_off + (uint64_t)head->groups * sizeof(Group) <= len,
+                "truncated file " + filename);
+            // every record and group has to point inside the sections
+            const Record* rec = (const Record*)(base + head->record_off);
+            for (uint32_t i = 0; i < head->instances; i++) {
+                const Record& r = rec[i];
+                check(r.domain < head->domains && r.eqs > 0
+                    && r.coeff + (uint64_t)r.eqs * ((uint64_t)r.terms + 1) <= head->coeffs,
+                    "bad record in " + filename);
+            }
+            const Group* grp = (const Group*)(base + head->group_off);
+            for (uint32_t i = 0; i < head->groups; i++)
+                check((uint64_t)grp[i].first + grp[i].count <= head->instances, "bad group in " + filename);
+        }
+        Reader(const Reader&) = delete;
+        Reader& operator =(const Reader&) = delete;
+        ~Reader(void) {
+            unmap();
+        }
+
+        char suite(void) const { return (char)head->suite; }
+        const Header& header(void) const { return *head; }
+        size_t size(void) const { return head->instances; }
+        size_t groups(void) const { return head->groups; }
+
+        const Group& group(size_t i) const {
+            return ((const Group*)(base + head->group_off))[i];
+        }
+
+        InstanceView operator [](size_t i) const {
+            const Record* r = (const Record*)(base + head->record_off) + i;
+            return InstanceView(r,
+                (const Domain*)(base + head->domain_off) + r->domain,
+                (const int32_t*)(base + head->coeff_off) + r->coeff);
+        }
+    };
+};
+
+// STATISTICS: example-any
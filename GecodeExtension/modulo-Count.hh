@@ -0,0 +1,190 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+// Search-free solution counting for sum a_i x_i = c over a box lo <= x_i <= hi
+//   single equation: dense dynamic programming over the partial sums, with x_i shifted to
+//                    y_i in [0, w] and negative coefficients flipped, so only sums in [0, T] matter.
+//                    Each term is a sliding window per residue class of its coefficient, O(T) per term.
+//   several equations: sparse dynamic programming over the vector of partial sums, pruned
+//                    by what the remaining terms can still reach.
+// Counts are exact uint64, an overflow or a state space over the limits gives up so the caller
+// can fall back to search.
+namespace Count {
+    // operations the sparse count may spend
+    const uint64_t WORK_LIMIT = 1ull << 30;
+
+    struct Result {
+        bool exact = false;         ///< counted, false if it did not fit or overflowed
+        uint64_t solutions = 0;
+        size_t memory = 0;          ///< estimated bytes of the tables
+        double runtime = 0;         ///< milliseconds
+        const char* method = "none";
+    };
+
+    inline bool add(uint64_t& a, uint64_t b) {
+        if (a > std::numeric_limits<uint64_t>::max() - b) return false;
+        a += b;
+        return true;
+    }
+    inline bool mul(uint64_t& a, uint64_t b) {
+        if (b != 0 && a > std::numeric_limits<uint64_t>::max() / b) return false;
+        a *= b;
+        return true;
+    }
+
+    // one equation, shifted to non-negative variables
+    struct Shifted {
+        std::vector<long long> b;   ///< positive coefficients
+        long long w = 0;            ///< width of every y_i
+        long long target = 0;       ///< T
+        long long reach = 0;        ///< largest reachable sum
+        int zeros = 0;              ///< terms with a zero coefficient, free variables
+    };
+
+    // row is c, a_0, a_1, ...
+    inline Shifted shift(const std::vector<int>& row, int lo, int hi) {
+        Shifted s;
+        s.w = (long long)hi - lo;
+        s.target = row[0];
+        for (size_t i = 1; i < row.size(); i++) {
+            long long a = row[i];
+            if (a == 0) {
+                s.zeros++;
+                continue;
+            }
+            // a x = a lo + a y, and for a < 0, a y = |a| (w - y) - |a| w
+            s.target -= a * lo;
+            if (a < 0) {
+                s.target -= a * s.w;
+                a = -a;
+            }
+            s.b.push_back(a);
+            s.reach += a * s.w;
+        }
+        return s;
+    }
+
+    // bytes the dense count needs for row
+    inline size_t estimate(const std::vector<int>& row, int lo, int hi) {
+        Shifted s = shift(row, lo, hi);
+        if (s.target < 0 || s.target > s.reach) return 0;
+        return 2 * (size_t)(s.target + 1) * sizeof(uint64_t);
+    }
+
+    // dense count of one equation
+    inline Result dense(const std::vector<int>& row, int lo, int hi, size_t memory) {
+        Result r;
+        r.method = "dp";
+        Shifted s = shift(row, lo, hi);
+        r.memory = estimate(row, lo, hi);
+        if (r.memory > memory) return r;
+        r.exact = true;
+        if (s.target < 0 || s.target > s.reach) return r;
+
+        const long long T = s.target;
+        std::vector<uint64_t> cur(T + 1, 0), nxt(T + 1, 0);
+        cur[0] = 1;
+        for (long long b : s.b) {
+            // window of w + 1 values of y, spaced b apart
+            const long long span = s.w + 1 > T / b + 1 ? T + 1 : (s.w + 1) * b;
+            for (long long res = 0; res < b && res <= T; res++) {
+                uint64_t win = 0;
+                for (long long t = res; t <= T; t += b) {
+                    if (t - span >= 0) win -= cur[t - span];
+                    if (!add(win, cur[t])) {
+                        r.exact = false;
+                        return r;
+                    }
+                    nxt[t] = win;
+                }
+            }
+            cur.swap(nxt);
+        }
+        r.solutions = cur[T];
+        for (int z = 0; z < s.zeros; z++) {
+            if (!mul(r.solutions, (uint64_t)s.w + 1)) {
+                r.exact = false;
+                return r;
+            }
+        }
+        return r;
+    }
+
+    struct StateHash {
+        size_t operator ()(const std::vector<long long>& v) const {
+            size_t h = 1469598103934665603ull;
+            for (long long x : v) h = (h ^ std::hash<long long>()(x)) * 1099511628211ull;
+            return h;
+        }
+    };
+
+    // sparse count of several equations over the same variables
+    inline Result sparse(const std::vector<std::vector<int>>& rows, int lo, int hi, size_t memory) {
+        Result r;
+        r.method = "sparse dp";
+        const size_t eqs = rows.size();
+        const size_t n = rows[0].size() - 1;
+        const size_t state_bytes = eqs * sizeof(long long) + sizeof(uint64_t) + 4 * sizeof(void*);
+
+        // what the terms from i on can still add, per equation
+        std::vector<std::vector<long long>> smin(n + 1, std::vector<long long>(eqs, 0)), smax = smin;
+        for (size_t i = n; i-- > 0; ) {
+            for (size_t e = 0; e < eqs; e++) {
+                long long a = rows[e][i + 1];
+                smin[i][e] = smin[i + 1][e] + std::min(a * lo, a * hi);
+                smax[i][e] = smax[i + 1][e] + std::max(a * lo, a * hi);
+            }
+        }
+
+        using Table = std::unordered_map<std::vector<long long>, uint64_t, StateHash>;
+        Table cur, nxt;
+        cur.emplace(std::vector<long long>(eqs, 0), 1);
+        uint64_t work = 0;
+        for (size_t i = 0; i < n; i++) {
+            nxt.clear();
+            for (auto const& st : cur) {
+                work += (uint64_t)hi - lo + 1;
+                if (work > WORK_LIMIT) return r;
+                std::vector<long long> s(eqs);
+                for (long long v = lo; v <= hi; v++) {
+                    bool ok = true;
+                    for (size_t e = 0; e < eqs && ok; e++) {
+                        s[e] = st.first[e] + rows[e][i + 1] * v;
+                        long long rest = rows[e][0] - s[e];
+                        ok = rest >= smin[i + 1][e] && rest <= smax[i + 1][e];
+                    }
+                    if (!ok) continue;
+                    if (!add(nxt[s], st.second)) return r;
+                }
+                r.memory = std::max(r.memory, nxt.size() * state_bytes);
+                if (r.memory > memory) return r;
+            }
+            cur.swap(nxt);
+        }
+        r.exact = true;
+        for (auto const& st : cur) {
+            bool solved = true;
+            for (size_t e = 0; e < eqs; e++) solved = solved && st.first[e] == rows[e][0];
+            if (solved) r.solutions += st.second;
+        }
+        return r;
+    }
+
+    // count the solutions of every row, rows[e] = c, a_0, a_1, ... with lo <= x_i <= hi
+    inline Result count(const std::vector<std::vector<int>>& rows, int lo, int hi, size_t memory) {
+        auto start = std::chrono::steady_clock::now();
+        Result r = rows.size() == 1 ? dense(rows[0], lo, hi, memory) : sparse(rows, lo, hi, memory);
+        r.runtime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return r;
+    }
+};
+
+// STATISTICS: example-any
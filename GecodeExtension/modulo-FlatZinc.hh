@@ -0,0 +1,31 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <gecode/flatzinc.hh>
+#include <gecode/flatzinc/registry.hh>
+
+#include "modulo_propogator.hpp"
+
+// FlatZinc bindings for the modulo propagation
+//
+//   gecode_modulo_int_lin_eq(a, x, c)   always posts modulo()
+//   int_lin_eq(a, x, c)                 posts modulo() instead of linear() when registered with override
+namespace ModFlatZinc {
+    using namespace Gecode::FlatZinc;
+
+    // a[] * x[] = c with the modulo propagator (and the linear one it posts itself)
+    void p_modulo_int_lin_eq(FlatZincSpace& s, const ConExpr& ce, AST::Node* ann) {
+        IntArgs a = s.arg2intargs(ce[0]);
+        IntVarArgs x = s.arg2intvarargs(ce[1]);
+        modulo(s, a, x, ce[2]->getInt(), s.ann2ipl(ann));
+    }
+
+    // register the global, and optionally take over int_lin_eq
+    void register_modulo(bool int_lin_eq) {
+        registry().add("gecode_modulo_int_lin_eq", &p_modulo_int_lin_eq);
+        if (int_lin_eq)
+            registry().add("int_lin_eq", &p_modulo_int_lin_eq);
+    }
+};
+
+// STATISTICS: flatzinc-any
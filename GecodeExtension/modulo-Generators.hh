@@ -0,0 +1,254 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <exception>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "modulo-Corpus.hh"
+
+// Parametric instance families
+//
+// every instance is generated from its own generator seeded by (seed, family, index),
+// so any instance can be rebuilt on its own and corpora can be generated in parallel.
+namespace Generators {
+    // recorded in every corpus, bump it when a family or generate_tests changes so old corpora are rebuilt
+    const uint32_t VERSION = 1;
+
+    // families, numbered after the hard-coded suites
+    enum Family {
+        MARKET_SPLIT = 16,      ///< Cornuejols-Dawande market split
+        NEAR_FROBENIUS,         ///< RHS around the Frobenius number
+        INFEASIBLE_CONGRUENCE,  ///< infeasible by the coefficient gcd
+        MULTI_EQUATION,         ///< several equations over shared variables
+        WIDE,                   ///< 10^2 - 10^4 terms
+    };
+
+    // corpus suite tag per family
+    inline char suite_tag(int family) {
+        switch (family) {
+        case MARKET_SPLIT:          return 'M';
+        case NEAR_FROBENIUS:        return 'F';
+        case INFEASIBLE_CONGRUENCE: return 'C';
+        case MULTI_EQUATION:        return 'S';
+        case WIDE:                  return 'W';
+        default:                    return Corpus::SUITE_GENERATED;
+        }
+    }
+
+    // splitmix64 finaliser, decorrelates neighbouring seeds
+    inline uint64_t mix(uint64_t z) {
+        z += 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    using Rng = std::mt19937_64;
+
+    inline Rng rng(uint64_t seed, int family, int index) {
+        return Rng(mix(mix(seed ^ (uint64_t)family) ^ (uint64_t)index));
+    }
+
+    inline int uniform(Rng& r, int lo, int hi) {
+        return std::uniform_int_distribution<int>(lo, hi)(r);
+    }
+
+    // c = a . x for a planted x, fails if it does not fit an int
+    inline int planted_rhs(const std::vector<int>& row, const std::vector<int>& x) {
+        int64_t c = 0;
+        for (size_t j = 0; j < x.size(); j++) c += (int64_t)row[j + 1] * x[j];
+        if (c > INT_MAX || c < INT_MIN)
+            throw std::overflow_error("Generators: right hand side does not fit an int");
+        return (int)c;
+    }
+
+    // Market split: m equations over n = 10 (m - 1) binary variables,
+    // a_ij in [0, d), c_i = floor(sum_j a_ij / 2). Hard for branching on small m already.
+    Corpus::Instance market_split(uint64_t seed, int index, int m, int d = 100) {
+        Rng r = rng(seed, MARKET_SPLIT, index);
+        const int n = 10 * (m - 1);
+        Corpus::Instance inst;
+        inst.id = index;
+        inst.dom_min = 0;
+        inst.dom_max = 1;
+        for (int i = 0; i < m; i++) {
+            std::vector<int> row(n + 1);
+            int sum = 0;
+            for (int j = 1; j <= n; j++) {
+                row[j] = uniform(r, 0, d - 1);
+                sum += row[j];
+            }
+            row[0] = sum / 2;
+            inst.rows.push_back(row);
+        }
+        return inst;
+    }
+
+    // Frobenius number of coprime positive a[], via shortest paths over the residues of min(a)
+    // (Nijenhuis), O(min(a) * n log min(a))
+    int64_t frobenius(const std::vector<int>& a) {
+        const int a0 = *std::min_element(a.begin(), a.end());
+        std::vector<int64_t> dist(a0, INT64_MAX);
+        std::priority_queue<std::pair<int64_t, int>, std::vector<std::pair<int64_t, int>>, std::greater<>> q;
+        dist[0] = 0;
+        q.push({ 0, 0 });
+        while (!q.empty()) {
+            auto [d, v] = q.top();
+            q.pop();
+            if (d != dist[v]) continue;
+            for (int ai : a) {
+                int w = (int)((v + (int64_t)ai) % a0);
+                if (d + ai < dist[w]) {
+                    dist[w] = d + ai;
+                    q.push({ dist[w], w });
+                }
+            }
+        }
+        return *std::max_element(dist.begin(), dist.end()) - a0;
+    }
+
+    // Near Frobenius: n coprime coefficients in [a_max / 2, a_max], c = F + offset over [0, c / min(a)].
+    // offset 0 is infeasible, and every offset > 0 is feasible, but only barely.
+    Corpus::Instance near_frobenius(uint64_t seed, int index, int n, int a_max = 1000, int offset = 0) {
+        Rng r = rng(seed, NEAR_FROBENIUS, index);
+        std::vector<int> a(n);
+        int g;
+        do {
+            g = 0;
+            for (int& ai : a) {
+                ai = uniform(r, std::max(1, a_max / 2), a_max);
+                g = std::gcd(g, ai);
+            }
+        } while (g != 1);
+        int64_t c = frobenius(a) + offset;
+        if (c > INT_MAX)
+            throw std::overflow_error("Generators: Frobenius number does not fit an int");
+
+        Corpus::Instance inst;
+        inst.id = index;
+        inst.dom_min = 0;
+        inst.dom_max = (int)(c / *std::min_element(a.begin(), a.end()));
+        std::vector<int> row{ (int)c };
+        row.insert(row.end(), a.begin(), a.end());
+        inst.rows.push_back(row);
+        return inst;
+    }
+
+    // Infeasible by congruence: every coefficient is a multiple of g, c is not.
+    // The coefficients are large and mixed in sign so the bounds alone do not show it.
+    Corpus::Instance infeasible_congruence(uint64_t seed, int index, int n, int g = 7, int dom = 1000) {
+        Rng r = rng(seed, INFEASIBLE_CONGRUENCE, index);
+        const int a_max = INT_MAX / (2 * n * dom * g);
+        std::vector<int> row(n + 1), x(n);
+        for (int j = 1; j <= n; j++) {
+            row[j] = g * uniform(r, 1, std::max(1, a_max)) * (uniform(r, 0, 1) ? 1 : -1);
+            x[j - 1] = uniform(r, 0, dom);
+        }
+        // planted value shifted off the lattice
+        row[0] = planted_rhs(row, x) + uniform(r, 1, g - 1);
+
+        Corpus::Instance inst;
+        inst.id = index;
+        inst.dom_min = 0;
+        inst.dom_max = dom;
+        inst.rows.push_back(row);
+        return inst;
+    }
+
+    // Multi equation: m feasible equations sharing all n variables, with a planted solution
+    Corpus::Instance multi_equation(uint64_t seed, int index, int m, int n, int a_max = 1000, int dom = 100) {
+        Rng r = rng(seed, MULTI_EQUATION, index);
+        std::vector<int> x(n);
+        for (int& xi : x) xi = uniform(r, 0, dom);
+
+        Corpus::Instance inst;
+        inst.id = index;
+        inst.dom_min = 0;
+        inst.dom_max = dom;
+        for (int i = 0; i < m; i++) {
+            std::vector<int> row(n + 1);
+            for (int j = 1; j <= n; j++) row[j] = uniform(r, -a_max, a_max);
+            row[0] = planted_rhs(row, x);
+            inst.rows.push_back(row);
+        }
+        return inst;
+    }
+
+    // Wide: a single feasible equation with n (10^2 - 10^4) non-zero terms of mixed sign
+    Corpus::Instance wide(uint64_t seed, int index, int n, int a_max = 1000, int dom = 100) {
+        Rng r = rng(seed, WIDE, index);
+        std::vector<int> row(n + 1), x(n);
+        for (int j = 1; j <= n; j++) {
+            row[j] = uniform(r, 1, a_max) * (uniform(r, 0, 1) ? 1 : -1);
+            x[j - 1] = uniform(r, 0, dom);
+        }
+        row[0] = planted_rhs(row, x);
+
+        Corpus::Instance inst;
+        inst.id = index;
+        inst.dom_min = 0;
+        inst.dom_max = dom;
+        inst.rows.push_back(row);
+        return inst;
+    }
+
+    // smallest size a family generates instances for, 0 for the hard-coded suites: a single Frobenius coefficient is never
+    // coprime, and market split with one equation has no variables
+    inline int min_size(int family) {
+        return family == NEAR_FROBENIUS || family == MARKET_SPLIT ? 2 : family >= MARKET_SPLIT ? 1 : 0;
+    }
+
+    // instance index of a family, size is the main parameter
+    //   (equations for market split and multi equation, terms otherwise)
+    Corpus::Instance generate(int family, uint64_t seed, int index, int size) {
+        switch (family) {
+        case MARKET_SPLIT:          return market_split(seed, index, size);
+        case NEAR_FROBENIUS:        return near_frobenius(seed, index, size, 1000, index % 3);
+        case INFEASIBLE_CONGRUENCE: return infeasible_congruence(seed, index, size);
+        case MULTI_EQUATION:        return multi_equation(seed, index, size, 2 * size);
+        case WIDE:                  return wide(seed, index, size);
+        default:
+            throw std::invalid_argument("Generators: unknown family");
+        }
+    }
+
+    // write num instances of a family, generating blocks of them in parallel
+    void write_family(Corpus::Writer& w, int family, uint64_t seed, int num, int size) {
+        if (size < min_size(family))
+            throw std::invalid_argument("Generators: size " + std::to_string(size) + " too small for this family, at least "
+                + std::to_string(min_size(family)) + " needed");
+        const int threads = std::max(1u, std::thread::hardware_concurrency());
+        const int block = 64 * threads;
+        std::vector<Corpus::Instance> out(block);
+        for (int first = 0; first < num; first += block) {
+            const int count = std::min(block, num - first);
+            std::vector<std::thread> pool;
+            std::vector<std::exception_ptr> err(threads);
+            for (int t = 0; t < threads; t++) {
+                pool.emplace_back([&, t]() {
+                    try {
+                        for (int i = t; i < count; i += threads)
+                            out[i] = generate(family, seed, first + i, size);
+                    } catch (...) {
+                        err[t] = std::current_exception();
+                    }
+                });
+            }
+            for (auto& th : pool) th.join();
+            for (auto const& e : err) if (e) std::rethrow_exception(e);
+            for (int i = 0; i < count; i++) w.add(out[i]);
+        }
+    }
+};
+
+// STATISTICS: example-any
@@ -0,0 +1,89 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <gecode/search.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <string>
+
+// Recomputation controller
+//   DFS with commit distance d pays a clone every d nodes and on average d / 2 recomputation steps
+//   per backtrack, about C / d + R d / 2 per node for clone cost C and step cost R, minimal at
+//   d = sqrt(2 C / R). Both costs are probed on the root of every run (a few clones, and a few
+//   commits with propagation), smoothed per instance family, and turned into c_d and a_d for the
+//   next run of that family. The engine fixes the distances for a whole run, so the adjustment
+//   happens between runs.
+namespace Recompute {
+    using Clock = std::chrono::steady_clock;
+
+    struct Estimate {
+        double clone = 0;       ///< ns per clone
+        double step = 0;        ///< ns per commit and propagation
+        int samples = 0;
+    };
+
+    // time n clones and n recomputation steps of root, which is left stable
+    template <class S>
+    Estimate probe(S* root, int n = 8) {
+        Estimate e;
+        if (root->status() != SS_BRANCH) return e;
+
+        auto start = Clock::now();
+        for (int i = 0; i < n; i++) delete root->clone();
+        e.clone = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+
+        const Choice* ch = root->choice();
+        double step = 0;
+        for (int i = 0; i < n; i++) {
+            Space* c = root->clone();
+            auto t = Clock::now();
+            c->commit(*ch, i % ch->alternatives());
+            (void) c->status();
+            step += std::chrono::duration<double, std::nano>(Clock::now() - t).count();
+            delete c;
+        }
+        delete ch;
+        e.step = step / n;
+        e.samples = 1;
+        return e;
+    }
+
+    class Controller {
+    protected:
+        double alpha;                           ///< weight of the newest probe
+        unsigned int max_d;                     ///< largest commit distance chosen
+        std::map<std::string, Estimate> family;
+    public:
+        Controller(double _alpha = 0.3, unsigned int _max_d = 64) : alpha(_alpha), max_d(_max_d) {}
+
+        // fold a probe into the moving average of its family
+        const Estimate& update(const std::string& key, const Estimate& p) {
+            Estimate& e = family[key];
+            if (p.samples == 0) return e;
+            if (e.samples == 0) {
+                e = p;
+            } else {
+                e.clone = alpha * p.clone + (1 - alpha) * e.clone;
+                e.step = alpha * p.step + (1 - alpha) * e.step;
+                e.samples++;
+            }
+            return e;
+        }
+
+        // commit and adaptive distance for a family, the engine defaults until it has been probed
+        void distances(const std::string& key, unsigned int& c_d, unsigned int& a_d) const {
+            c_d = Search::Config::c_d;
+            a_d = Search::Config::a_d;
+            auto it = family.find(key);
+            if (it == family.end() || it->second.samples == 0 || it->second.step <= 0) return;
+            const double d = std::sqrt(2 * it->second.clone / it->second.step);
+            c_d = std::min(max_d, std::max(1u, (unsigned int)std::lround(d)));
+            a_d = std::max(1u, c_d / 2);
+        }
+    };
+};
+
+// STATISTICS: example-any
@@ -0,0 +1,106 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Solution sink, takes solutions off the formatted ostream path
+//   print:    leave printing to the script
+//   binary:   packed int32 rows, buffered and written in batches
+//             file layout: "MODS", int32 width, then width int32 per solution
+//   callback: the same batches handed to a function
+//   count:    only count (and deduplicate) solutions
+namespace Sink {
+    enum Mode {
+        PRINT,
+        BINARY,
+        CALLBACK,
+        COUNT
+    };
+
+    // rows solutions of width values each, packed one after the other
+    using Callback = std::function<void(const int32_t* rows, size_t count, int width)>;
+
+    class Sink {
+    protected:
+        Mode mode;
+        size_t batch;               ///< solutions per flush
+        bool dedupe;
+        int width = 0;
+        std::vector<int32_t> buf;   ///< allocated once per open
+        std::vector<int32_t> row;   ///< scratch row for variable arrays
+        size_t used = 0;            ///< solutions in buf
+        FILE* file = NULL;
+        Callback cb;
+        std::unordered_set<std::string> seen;
+    public:
+        unsigned long long solutions = 0;   ///< solutions pushed
+        unsigned long long unique = 0;      ///< of those, kept after deduplication
+        unsigned long long batches = 0;     ///< flushes that wrote something
+
+        Sink(Mode _mode = PRINT, size_t _batch = 4096, bool _dedupe = false)
+            : mode(_mode), batch(_batch > 0 ? _batch : 1), dedupe(_dedupe) {}
+        ~Sink(void) { close(); }
+
+        bool active(void) const { return mode != PRINT; }
+        Mode type(void) const { return mode; }
+
+        // start a run of solutions with width values each, filename is used in binary mode
+        void open(int _width, const std::string& filename = "") {
+            close();
+            width = _width;
+            solutions = unique = batches = 0;
+            seen.clear();
+            if (mode == BINARY) {
+                file = fopen(filename.c_str(), "wb");
+                if (file == NULL)
+                    throw std::runtime_error("Sink: cannot open " + filename);
+                int32_t w = width;
+                fwrite("MODS", 1, 4, file);
+                fwrite(&w, sizeof(w), 1, file);
+            }
+            if (mode == BINARY || mode == CALLBACK) buf.assign(batch * width, 0);
+            row.assign(width, 0);
+            used = 0;
+        }
+        void callback(Callback f) { cb = f; }
+
+        // push one solution
+        void push_row(const int32_t* values) {
+            solutions++;
+            if (dedupe && !seen.emplace(reinterpret_cast<const char*>(values), width * sizeof(int32_t)).second)
+                return;
+            unique++;
+            if (mode == COUNT || mode == PRINT) return;
+            std::copy(values, values + width, buf.begin() + used * width);
+            if (++used == batch) flush();
+        }
+        // push the values of an assigned variable array
+        template <class VarArray>
+        void push(const VarArray& x) {
+            for (int i = 0; i < width; i++) row[i] = x[i].val();
+            push_row(row.data());
+        }
+
+        void flush(void) {
+            if (used == 0) return;
+            if (mode == BINARY && file != NULL) fwrite(buf.data(), sizeof(int32_t), used * width, file);
+            if (mode == CALLBACK && cb) cb(buf.data(), used, width);
+            used = 0;
+            batches++;
+        }
+        void close(void) {
+            flush();
+            if (file != NULL) fclose(file);
+            file = NULL;
+        }
+    };
+};
+
+// STATISTICS: example-any
@@ -0,0 +1,64 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+// Summary statistics for repeated timings
+namespace Stats {
+    struct Summary {
+        int n = 0;
+        double mean = 0;
+        double stddev = 0;      ///< sample standard deviation
+        double median = 0;
+        double min = 0;
+        double max = 0;
+    };
+
+    inline double median(std::vector<double> v) {
+        if (v.empty()) return 0;
+        size_t h = v.size() / 2;
+        std::nth_element(v.begin(), v.begin() + h, v.end());
+        if (v.size() % 2 == 1) return v[h];
+        return (v[h] + *std::max_element(v.begin(), v.begin() + h)) / 2;
+    }
+
+    inline Summary summarise(const std::vector<double>& v) {
+        Summary s;
+        s.n = (int)v.size();
+        if (v.empty()) return s;
+        for (double d : v) s.mean += d;
+        s.mean /= v.size();
+        for (double d : v) s.stddev += (d - s.mean) * (d - s.mean);
+        s.stddev = v.size() > 1 ? std::sqrt(s.stddev / (v.size() - 1)) : 0;
+        s.median = median(v);
+        auto mm = std::minmax_element(v.begin(), v.end());
+        s.min = *mm.first;
+        s.max = *mm.second;
+        return s;
+    }
+
+    // percentile bootstrap confidence interval for median(now) / median(base)
+    template <class Rng>
+    std::pair<double, double> bootstrap_ratio(const std::vector<double>& base, const std::vector<double>& now,
+        Rng& rng, int resamples = 2000, double alpha = 0.05) {
+        std::uniform_int_distribution<size_t> pick_base(0, base.size() - 1);
+        std::uniform_int_distribution<size_t> pick_now(0, now.size() - 1);
+        std::vector<double> ratios(resamples);
+        std::vector<double> b(base.size()), n(now.size());
+        for (double& r : ratios) {
+            for (double& d : b) d = base[pick_base(rng)];
+            for (double& d : n) d = now[pick_now(rng)];
+            r = median(n) / median(b);
+        }
+        std::sort(ratios.begin(), ratios.end());
+        size_t lo = (size_t)(alpha / 2 * (resamples - 1));
+        size_t hi = (size_t)((1 - alpha / 2) * (resamples - 1));
+        return { ratios[lo], ratios[hi] };
+    }
+};
+
+// STATISTICS: example-any
@@ -0,0 +1,250 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+
+#include <gecode/driver.hh>
+#include <gecode/int.hh>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+#include "modulo_propogator.hpp"
+#include "modulo-Stats.hh"
+
+using namespace Gecode;
+
+// Microbenchmarks for the modulo hot paths, without any search around them
+//   propagate: one Mod::Modulo::propagate call after assigning a fraction of the terms
+//   modinter:  ModInter construction from a term
+//   gcd:       extended_gcd on random pairs
+
+/// Options for the benchmarks
+class BenchOptions : public Options {
+protected:
+    Driver::StringOption _bench;        ///< what to benchmark
+    Driver::UnsignedIntOption _terms;   ///< number of terms
+    Driver::UnsignedIntOption _coeff;   ///< coefficient magnitude
+    Driver::UnsignedIntOption _dom;     ///< domain size
+    Driver::DoubleOption _assigned;     ///< fraction of terms assigned before the call
+    Driver::UnsignedIntOption _warmup;  ///< warm-up repetitions
+    Driver::UnsignedIntOption _reps;    ///< measured repetitions
+    Driver::UnsignedIntOption _calls;   ///< calls per repetition
+    Driver::UnsignedIntOption _seed;    ///< random seed
+    Driver::StringOption _stage;        ///< propagation stage to call
+public:
+    enum {
+        BENCH_PROPAGATE,
+        BENCH_MODINTER,
+        BENCH_GCD
+    };
+    enum {
+        STAGE_FOLD,     ///< assignment folding only
+        STAGE_PRUNE     ///< full congruence pruning
+    };
+    BenchOptions(const char* s)
+        : Options(s),
+        _bench("bench", "what to benchmark", BENCH_PROPAGATE),
+        _terms("terms", "number of terms", 8),
+        _coeff("coeff", "coefficient magnitude", 1000),
+        _dom("dom", "domain size", 1000),
+        _assigned("assigned", "fraction of terms assigned before the call", 0.5),
+        _warmup("warmup", "warm-up repetitions", 3),
+        _reps("reps", "measured repetitions", 20),
+        _calls("calls", "calls per repetition", 1000),
+        _seed("seed", "random seed", 1000),
+        _stage("stage", "propagation stage to call", STAGE_PRUNE) {
+        _bench.add(BENCH_PROPAGATE, "propagate");
+        _bench.add(BENCH_MODINTER, "modinter");
+        _bench.add(BENCH_GCD, "gcd");
+        add(_bench);
+        add(_terms);
+        add(_coeff);
+        add(_dom);
+        add(_assigned);
+        add(_warmup);
+        add(_reps);
+        add(_calls);
+        add(_seed);
+        _stage.add(STAGE_FOLD, "fold");
+        _stage.add(STAGE_PRUNE, "prune");
+        add(_stage);
+    }
+    int bench(void) const { return _bench.value(); }
+    int terms(void) const { return _terms.value(); }
+    int coeff(void) const { return _coeff.value(); }
+    int dom(void) const { return _dom.value(); }
+    double assigned(void) const { return _assigned.value(); }
+    int warmup(void) const { return _warmup.value(); }
+    int reps(void) const { return _reps.value(); }
+    int calls(void) const { return _calls.value(); }
+    unsigned int seed(void) const { return _seed.value(); }
+    int stage(void) const { return _stage.value(); }
+};
+
+class BenchSpace;
+
+/// Modulo that registers itself with the space it lives in, so every clone's propagator can be called directly
+class BenchModulo : public Mod::Modulo<Int::IntView> {
+public:
+    BenchModulo(Home home, TArray ax, int c);
+    BenchModulo(Space& home, BenchModulo& p);
+    virtual Actor* copy(Space& home) {
+        return new (home) BenchModulo(home, *this);
+    }
+};
+
+/// Space holding one synthetic equation with only the modulo propagator
+class BenchSpace : public Space {
+public:
+    IntVarArray x;
+    std::vector<int> a;
+    std::vector<int> v;     ///< planted solution
+    BenchModulo* modulo = nullptr;  ///< the propagator of this space, set by its constructors
+
+    BenchSpace(const BenchOptions& opt, std::mt19937& rng)
+        : x(*this, opt.terms(), 0, opt.dom() - 1) {
+        std::uniform_int_distribution<int> coeff(1, opt.coeff());
+        std::uniform_int_distribution<int> val(0, opt.dom() - 1);
+        long long c = 0;
+        TArray ax(*this, opt.terms());
+        for (int i = 0; i < opt.terms(); i++) {
+            a.push_back(coeff(rng) * (rng() % 2 ? 1 : -1));
+            v.push_back(val(rng));
+            c += (long long)a[i] * v[i];
+            ax[i].a = a[i];
+            ax[i].x = x[i];
+            ax[i].p = i;
+        }
+        (void) new (*this) BenchModulo(*this, ax, (int)c);
+    }
+    BenchSpace(BenchSpace& s) : Space(s), a(s.a), v(s.v) {
+        x.update(*this, s.x);
+    }
+    virtual Space* copy(void) {
+        return new BenchSpace(*this);
+    }
+};
+
+BenchModulo::BenchModulo(Home home, TArray ax, int c)
+    : Mod::Modulo<Int::IntView>(home, ax, c) {
+    static_cast<BenchSpace&>(static_cast<Space&>(home)).modulo = this;
+}
+// propagators are copied after the space itself, so the clone is complete here
+BenchModulo::BenchModulo(Space& home, BenchModulo& p)
+    : Mod::Modulo<Int::IntView>(home, p) {
+    static_cast<BenchSpace&>(home).modulo = this;
+}
+
+using Clock = std::chrono::steady_clock;
+
+// time reps of calls, returning ns per call for each measured repetition
+template <class Prepare, class Call>
+std::vector<double> measure(const BenchOptions& opt, Prepare prepare, Call call) {
+    std::vector<double> ns;
+    for (int r = 0; r < opt.warmup() + opt.reps(); r++) {
+        prepare();
+        auto start = Clock::now();
+        for (int i = 0; i < opt.calls(); i++) call(i);
+        auto end = Clock::now();
+        if (r >= opt.warmup())
+            ns.push_back(std::chrono::duration<double, std::nano>(end - start).count() / opt.calls());
+    }
+    return ns;
+}
+
+std::vector<double> bench_propagate(const BenchOptions& opt, std::mt19937& rng) {
+    BenchSpace root(opt, rng);
+    (void) root.status();
+    // keep at least four terms unassigned, with fewer the propagator subsumes itself or rewrites into
+    // ModuloTer during the call and the timed loop would no longer measure Modulo
+    const int k = std::max(0, std::min((int)(opt.assigned() * opt.terms()), opt.terms() - 4));
+    // assignments wake the folding stage, the pruning stage is scheduled with ME_INT_DOM
+    const ModEventDelta med = Int::IntView::med(opt.stage() == BenchOptions::STAGE_FOLD ? Int::ME_INT_VAL : Int::ME_INT_DOM);
+
+    // clones are prepared outside the timed loop
+    std::vector<BenchSpace*> spaces(opt.calls());
+    std::vector<BenchModulo*> props(opt.calls());
+    auto prepare = [&]() {
+        for (int i = 0; i < opt.calls(); i++) {
+            delete spaces[i];
+            spaces[i] = static_cast<BenchSpace*>(root.clone());
+            props[i] = spaces[i]->modulo;
+            for (int j = 0; j < k; j++) rel(*spaces[i], spaces[i]->x[j], IRT_EQ, root.v[j]);
+        }
+    };
+    auto ns = measure(opt, prepare, [&](int i) {
+        (void) props[i]->propagate(*spaces[i], med);
+    });
+    for (BenchSpace* s : spaces) delete s;
+    return ns;
+}
+
+std::vector<double> bench_modinter(const BenchOptions& opt, std::mt19937& rng) {
+    BenchSpace root(opt, rng);
+    std::uniform_int_distribution<int> mod(2, std::max(2, opt.coeff()));
+    std::vector<TView> terms(opt.calls());
+    for (int i = 0; i < opt.calls(); i++) {
+        terms[i].x = root.x[i % opt.terms()];
+        terms[i].a = root.a[i % opt.terms()];
+        int m = mod(rng);
+        terms[i].modDom = Mod::ModDomain((int)(rng() % m), m);
+    }
+    volatile int sink = 0;
+    return measure(opt, [] {}, [&](int i) {
+        Mod::ModInter<Int::IntView> it(&terms[i]);
+        sink = sink + it.min();
+    });
+}
+
+std::vector<double> bench_gcd(const BenchOptions& opt, std::mt19937& rng) {
+    std::uniform_int_distribution<int> coeff(1, opt.coeff());
+    std::vector<std::pair<int, int>> pairs(opt.calls());
+    for (auto& p : pairs) p = { coeff(rng), coeff(rng) };
+    volatile int sink = 0;
+    return measure(opt, [] {}, [&](int i) {
+        sink = sink + std::get<0>(::extended_gcd(pairs[i].first, pairs[i].second));
+    });
+}
+
+/** \brief Main-function
+ *  \relates Mod::Modulo
+ */
+int
+main(int argc, char* argv[]) {
+    BenchOptions opt("ModuloBench");
+    opt.parse(argc, argv);
+    std::mt19937 rng(opt.seed());
+
+    std::vector<double> ns;
+    const char* name = "";
+    switch (opt.bench()) {
+    case BenchOptions::BENCH_PROPAGATE:
+        name = "propagate";
+        if (opt.terms() < 4) {
+            fprintf(stderr, "propagate needs at least 4 terms\n");
+            return 1;
+        }
+        if ((int)(opt.assigned() * opt.terms()) > opt.terms() - 4)
+            fprintf(stderr, "-assigned clamped to leave 4 terms unassigned\n");
+        ns = bench_propagate(opt, rng);
+        break;
+    case BenchOptions::BENCH_MODINTER:
+        name = "modinter";
+        ns = bench_modinter(opt, rng);
+        break;
+    case BenchOptions::BENCH_GCD:
+        name = "gcd";
+        ns = bench_gcd(opt, rng);
+        break;
+    }
+
+    Stats::Summary s = Stats::summarise(ns);
+    printf("%s%s terms=%d coeff=%d dom=%d assigned=%.2f reps=%d calls=%d\n",
+        name, opt.bench() != BenchOptions::BENCH_PROPAGATE ? "" : opt.stage() == BenchOptions::STAGE_FOLD ? " (fold)" : " (prune)",
+        opt.terms(), opt.coeff(), opt.dom(), opt.assigned(), opt.reps(), opt.calls());
+    printf("ns/call: mean %.1f  stddev %.1f (%.1f%%)  median %.1f  min %.1f  max %.1f\n",
+        s.mean, s.stddev, s.mean > 0 ? 100 * s.stddev / s.mean : 0.0, s.median, s.min, s.max);
+    return 0;
+}
+
+// STATISTICS: example-any
@@ -0,0 +1,69 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+
+#include <gecode/driver.hh>
+#include <gecode/flatzinc.hh>
+
+#include <cstring>
+#include <iostream>
+
+#include "modulo-FlatZinc.hh"
+
+using namespace Gecode;
+
+/// FlatZinc options with the modulo switch
+class ModFlatZincOptions : public FlatZinc::FlatZincOptions {
+protected:
+    Driver::BoolOption _modulo;     ///< post int_lin_eq with the modulo propagator
+public:
+    ModFlatZincOptions(const char* s)
+        : FlatZinc::FlatZincOptions(s),
+        _modulo("modulo", "post int_lin_eq with the modulo propagator", false) {
+        add(_modulo);
+    }
+    bool modulo(void) const { return _modulo.value(); }
+};
+
+/** \brief Main-function
+ *  FlatZinc front end with the modulo propagator registered, same usage as fzn-gecode
+ */
+int
+main(int argc, char* argv[]) {
+    Support::Timer t_total;
+    t_total.start();
+    ModFlatZincOptions opt("Gecode/FlatZinc + Modulo");
+    opt.parse(argc, argv);
+
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " [options] <file>" << std::endl;
+        std::cerr << "       " << argv[0] << " -help for more information" << std::endl;
+        return 1;
+    }
+
+    // has to happen before parsing, the parser posts through the registry
+    ModFlatZinc::register_modulo(opt.modulo());
+
+    const char* filename = argv[1];
+    opt.name(filename);
+
+    FlatZinc::Printer p;
+    FlatZinc::FlatZincSpace* fg = NULL;
+    try {
+        if (!strcmp(filename, "-")) {
+            fg = FlatZinc::parse(std::cin, p, std::cerr);
+        } else {
+            fg = FlatZinc::parse(filename, p, std::cerr);
+        }
+        if (fg == NULL)
+            return 1;
+        fg->createBranchers(p, fg->solveAnnotations(), opt, false, std::cerr);
+        fg->shrinkArrays(p);
+        fg->run(std::cout, p, opt, t_total);
+        delete fg;
+    } catch (FlatZinc::Error& e) {
+        std::cerr << "Error: " << e.toString() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// STATISTICS: flatzinc-any
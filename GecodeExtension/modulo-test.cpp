@@ -0,0 +1,128 @@
+/* -*- mode: C++; c-basic-offset: 2; indent-tabs-mode: nil -*- */
+
+#include <gecode/int.hh>
+#include <gecode/search.hh>
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "modulo_propogator.hpp"
+
+using namespace Gecode;
+
+// Checks of the modulo propagators against linear
+//   every check posts the same equations once with linear and once with modulo() and counts all
+//   solutions, the counts have to be the same. Pruning checks assign some variables and compare the
+//   bounds left with the expected ones. Exits with the number of failed checks.
+
+/// Equations a_e x = c_e over one box
+struct Model {
+    std::vector<std::vector<int>> a;
+    std::vector<int> c;
+    int lo, hi;
+};
+
+/// Space posting a model with linear or modulo
+class CheckSpace : public Space {
+public:
+    IntVarArray x;
+
+    CheckSpace(const Model& m, bool mod)
+        : x(*this, (int)m.a[0].size(), m.lo, m.hi) {
+        for (size_t e = 0; e < m.a.size(); e++) {
+            IntArgs a(m.a[e]);
+            if (mod) modulo(*this, a, x, m.c[e], IPL_DEF);
+            else linear(*this, a, x, IRT_EQ, m.c[e], IPL_DEF);
+        }
+        branch(*this, x, INT_VAR_NONE(), INT_VAL_MIN());
+    }
+    CheckSpace(CheckSpace& s) : Space(s) {
+        x.update(*this, s.x);
+    }
+    virtual Space* copy(void) {
+        return new CheckSpace(*this);
+    }
+};
+
+unsigned long int count(const Model& m, bool mod) {
+    CheckSpace* s = new CheckSpace(m, mod);
+    DFS<CheckSpace> e(s);
+    delete s;
+    unsigned long int n = 0;
+    while (CheckSpace* t = e.next()) {
+        delete t;
+        n++;
+    }
+    return n;
+}
+
+int failures = 0;
+
+void check(const std::string& name, const Model& m) {
+    const unsigned long int l = count(m, false);
+    const unsigned long int k = count(m, true);
+    if (l != k) {
+        failures++;
+        std::cout << "FAIL " << name << ": linear " << l << ", modulo " << k << std::endl;
+    } else {
+        std::cout << "ok   " << name << ": " << l << std::endl;
+    }
+}
+
+/// Assign x_i = v_i for the given values, then expect x_k in [lo, hi] under modulo()
+void check_bounds(const std::string& name, const Model& m, const std::vector<std::pair<int, int>>& assign,
+    int k, int lo, int hi) {
+    CheckSpace s(m, true);
+    for (auto const& iv : assign) rel(s, s.x[iv.first], IRT_EQ, iv.second);
+    const bool ok = s.status() != SS_FAILED && s.x[k].min() == lo && s.x[k].max() == hi;
+    if (!ok) {
+        failures++;
+        std::cout << "FAIL " << name << ": x" << k << " = " << s.x[k] << ", expected [" << lo << ".." << hi << "]" << std::endl;
+    } else {
+        std::cout << "ok   " << name << ": x" << k << " = " << s.x[k] << std::endl;
+    }
+}
+
+/// Random equations with a planted solution, coefficients sharing factors so classes arise
+Model random_model(std::mt19937& rng, int terms, int eqs, int lo, int hi) {
+    const int factors[] = { 2, 3, 5, 6 };
+    std::uniform_int_distribution<int> f(0, 3), k(1, 4), sign(0, 1), val(lo, hi);
+    Model m;
+    m.lo = lo;
+    m.hi = hi;
+    std::vector<int> v(terms);
+    for (int& vi : v) vi = val(rng);
+    for (int e = 0; e < eqs; e++) {
+        std::vector<int> a(terms);
+        long long c = 0;
+        for (int i = 0; i < terms; i++) {
+            a[i] = (i == 0 ? 1 : factors[f(rng)] * k(rng)) * (sign(rng) ? 1 : -1);
+            c += (long long)a[i] * v[i];
+        }
+        m.a.push_back(a);
+        m.c.push_back((int)c);
+    }
+    return m;
+}
+
+int main(int, char*[]) {
+    // x_0 is 1 mod 3 once x_3 is assigned, -2 lies below the first non-negative value of the class
+    check("negative class", Model{ { { 1, 3, 6, 2 } }, { 1 }, -3, 5 });
+    check("negative rhs", Model{ { { -4, 6, 9, 3 } }, { -7 }, -6, 2 });
+    // 6 x + 10 y + 15 z = 31 once w = 2, pairwise gcds 2, 3 and 5 but none for all three: x is 1 mod 5
+    // and linear alone leaves x in [0, 5]
+    check_bounds("triple classes", Model{ { { 6, 10, 15, 7 } }, { 45 }, 0, 10 }, { { 3, 2 } }, 0, 1, 1);
+    check("triple classes", Model{ { { 6, 10, 15, 7 } }, { 45 }, 0, 10 });
+
+    std::mt19937 rng(1000);
+    for (int r = 0; r < 20; r++)
+        check("random negative " + std::to_string(r), random_model(rng, 5, 1, -5, 4));
+    for (int r = 0; r < 10; r++)
+        check("random two equations " + std::to_string(r), random_model(rng, 5, 2, -4, 4));
+    return failures;
+}
+
+// STATISTICS: example-any
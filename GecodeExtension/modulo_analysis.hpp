@@ -0,0 +1,100 @@
+#pragma once
+
+#include <gecode/int.hh>
+
+#include <cmath>
+#include <vector>
+
+// expects gcd() from modulo_propogator.hpp
+
+namespace Mod {
+    // terms above this make every wake-up of Modulo quadratic enough to need a clear payoff
+#define WIDE_TERMS 64
+
+    // post-time estimate of what Modulo can prune
+    struct ModAnalysis {
+        int terms = 0;          ///< non-zero terms
+        int g = 0;              ///< gcd of all coefficients
+        int levels = 0;         ///< branching depths with more than one term left
+        int useful = 0;         ///< of those, depths where the remaining gcd is > 1
+        int pruning = 0;        ///< of those, depths where some congruence is tighter than the domain
+        double payoff = 0;      ///< pruning / levels
+        bool fails = false;     ///< g does not divide c
+        bool post = false;      ///< decision: post Modulo
+    };
+
+    // Modulo only acts while the gcd of the unassigned coefficients is > 1 (it returns at g == 1),
+    // and only prunes x_j when a_j x_j = RHS % G_j gives a modulus G_j / gcd(a_j, G_j) below the domain width,
+    // where G_j is the gcd of the other unassigned terms. The variables are branched on in order, so the
+    // unassigned terms at depth k are the suffix k..n-1.
+    ModAnalysis analyse(const IntArgs& a, const IntVarArgs& x, int c) {
+        ModAnalysis an;
+        std::vector<int> ai;
+        std::vector<unsigned int> width;
+        for (int i = 0; i < a.size(); i++) {
+            if (a[i] == 0 || x[i].assigned()) continue;
+            ai.push_back(std::abs(a[i]));
+            width.push_back(x[i].width());
+        }
+        an.terms = (int)ai.size();
+        const int n = an.terms;
+        if (n == 0) return an;
+
+        // suffix gcds, suf[n] is the neutral element
+        std::vector<int> suf(n + 1, INT_MAX);
+        for (int k = n - 1; k >= 0; k--) suf[k] = gcd(suf[k + 1], ai[k]);
+        an.g = suf[0];
+        an.fails = c % an.g != 0;
+
+        for (int k = 0; k + 1 < n; k++) {
+            an.levels++;
+            if (suf[k] <= 1) continue;
+            an.useful++;
+            // co-gcds inside the suffix from a running prefix
+            int pre = INT_MAX;
+            for (int j = k; j < n; j++) {
+                int G = gcd(pre, suf[j + 1]);
+                int m = G == INT_MAX ? 1 : G / gcd(ai[j], G);
+                if (m > 1 && (unsigned int)m < width[j]) {
+                    an.pruning++;
+                    break;
+                }
+                pre = gcd(pre, ai[j]);
+            }
+        }
+        an.payoff = an.levels > 0 ? (double)an.pruning / an.levels : 0;
+
+        // wide equations need pruning on at least half the depths to cover the per wake-up cost
+        an.post = an.fails || (n <= WIDE_TERMS ? an.pruning > 0 : an.payoff >= 0.5);
+        return an;
+    }
+
+    // post decisions and presolve results, reported by the harness after each run
+    struct PostStats {
+        unsigned long int posts = 0;    ///< equations analysed
+        unsigned long int modulo = 0;   ///< Modulo posted
+        unsigned long int folded = 0;   ///< assigned terms folded away by the presolve
+        unsigned long int merged = 0;   ///< duplicate variables merged by the presolve
+        unsigned long int divided = 0;  ///< equations with a common gcd divided out
+        unsigned long int decided = 0;  ///< equations failed or solved by the presolve
+        double presolve = 0;            ///< ms spent presolving
+        // analyses of all equations posted with modulo_auto, summed
+        unsigned long int lattice = 0;  ///< equations with a gcd > 1
+        unsigned long int fails = 0;    ///< equations failing by their gcd
+        unsigned long int levels = 0;
+        unsigned long int useful = 0;
+        unsigned long int pruning = 0;
+
+        void add(const ModAnalysis& an) {
+            posts++;
+            if (an.g > 1) lattice++;
+            if (an.fails) fails++;
+            levels += an.levels;
+            useful += an.useful;
+            pruning += an.pruning;
+        }
+        // pruning depths over all depths of the analysed equations
+        double payoff(void) const { return levels > 0 ? (double)pruning / levels : 0; }
+    };
+    static PostStats postStats;
+};
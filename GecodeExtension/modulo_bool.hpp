@@ -0,0 +1,159 @@
+#pragma once
+
+#include <gecode/int.hh>
+
+#include <bitset>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+// Boolean specialisation of Modulo, included from modulo_propogator.hpp
+
+namespace Mod {
+    // trailing zeros of a non-zero coefficient, the exponent of 2 in its gcds
+    inline int valuation(int a) {
+        unsigned int u = (unsigned int)a;
+        int v = 0;
+        while ((u & 1) == 0) {
+            u >>= 1;
+            v++;
+        }
+        return v;
+    }
+
+    // whether two coefficients share an odd factor, the only way an odd modulus can arise
+    inline bool odd_shared(const IntArgs& a) {
+        std::vector<long long> odd(a.size());
+        for (int i = 0; i < a.size(); i++) {
+            long long ai = a[i] < 0 ? -(long long)a[i] : a[i];
+            odd[i] = ai >> valuation(a[i]);
+        }
+        for (size_t i = 0; i < odd.size(); i++)
+            for (size_t j = i + 1; j < odd.size(); j++)
+                if (std::gcd(odd[i], odd[j]) > 1) return true;
+        return false;
+    }
+
+    // 0/1 equality knapsack sum a_i x_i = c over Boolean views
+    //   only the 2-adic part of the gcds is used. With v_i the trailing zeros of a_i and k the smallest
+    //   v_i of the unassigned terms, 2^k has to divide RHS, and if a single term has v_i = k it is decided by
+    //   RHS mod 2^k', k' the next smallest valuation (x = 0 if RHS = 0, x = 1 if RHS = a_i, fail otherwise).
+    //   The unassigned terms are kept in one bitset per valuation, so both facts are found with
+    //   word operations instead of the gcd per term of Modulo. This is complete only when no two
+    //   coefficients share an odd factor, see odd_shared().
+    class ModuloBool : public NaryPropagator<Int::BoolView, Int::PC_BOOL_VAL> {
+    protected:
+        using NaryPropagator<Int::BoolView, Int::PC_BOOL_VAL>::x;
+        static const int VALUATIONS = 32;
+
+        IntSharedArray a;   ///< coefficients, parallel to x
+        int RHS;
+        int words;          ///< words per bitset
+        uint64_t* live;     ///< unassigned terms, VALUATIONS bitsets of words each
+
+        uint64_t* set(int k) const { return live + k * words; }
+        bool unassigned(int i) const {
+            return (set(valuation(a[i]))[i >> 6] >> (i & 63)) & 1;
+        }
+        void remove(int i) {
+            set(valuation(a[i]))[i >> 6] &= ~(1ull << (i & 63));
+        }
+
+        ModuloBool(Home home, ViewArray<Int::BoolView>& x0, const IntSharedArray& a0, int c)
+            : NaryPropagator<Int::BoolView, Int::PC_BOOL_VAL>(home, x0), a(a0), RHS(c),
+            words((x0.size() + 63) >> 6) {
+            live = static_cast<Space&>(home).alloc<uint64_t>(VALUATIONS * words);
+            for (int i = 0; i < VALUATIONS * words; i++) live[i] = 0;
+            for (int i = 0; i < x.size(); i++)
+                set(valuation(a[i]))[i >> 6] |= 1ull << (i & 63);
+            home.notice(*this, AP_DISPOSE);
+        }
+        ModuloBool(Space& home, ModuloBool& p)
+            : NaryPropagator<Int::BoolView, Int::PC_BOOL_VAL>(home, p), a(p.a), RHS(p.RHS), words(p.words) {
+            live = home.alloc<uint64_t>(VALUATIONS * words);
+            for (int i = 0; i < VALUATIONS * words; i++) live[i] = p.live[i];
+        }
+    public:
+        virtual Actor* copy(Space& home) {
+            return new (home) ModuloBool(home, *this);
+        }
+        virtual size_t dispose(Space& home) {
+            home.ignore(*this, AP_DISPOSE);
+            a.~IntSharedArray();
+            (void) NaryPropagator<Int::BoolView, Int::PC_BOOL_VAL>::dispose(home);
+            return sizeof(*this);
+        }
+        virtual PropCost cost(const Space&, const ModEventDelta&) const {
+            return PropCost::linear(PropCost::LO, x.size());
+        }
+        virtual ExecStatus propagate(Space& home, const ModEventDelta& med);
+
+        // x and a hold the non-zero terms only
+        static ExecStatus post(Home home, ViewArray<Int::BoolView>& x, const IntArgs& a, int c) {
+            if (x.size() == 0) return c == 0 ? ES_OK : ES_FAILED;
+            (void) new (home) ModuloBool(home, x, IntSharedArray(a), c);
+            return ES_OK;
+        }
+    };
+
+    ExecStatus ModuloBool::propagate(Space& home, const ModEventDelta&) {
+        // fold assignments
+        for (int i = 0; i < x.size(); i++) {
+            if (!x[i].assigned() || !unassigned(i)) continue;
+            if (x[i].one()) RHS -= a[i];
+            remove(i);
+        }
+
+        for (;;) {
+            // the two smallest valuations, and the term if the smallest is unique
+            int k1 = -1, k2 = -1, term = -1;
+            size_t count = 0;
+            for (int k = 0; k < VALUATIONS && k2 < 0; k++) {
+                size_t c = 0;
+                int first = -1;
+                for (int w = 0; w < words; w++) {
+                    uint64_t bits = set(k)[w];
+                    if (bits == 0) continue;
+                    if (first < 0) {
+                        int b = 0;
+                        while (((bits >> b) & 1) == 0) b++;
+                        first = (w << 6) + b;
+                    }
+                    c += std::bitset<64>(bits).count();
+                }
+                if (c == 0) continue;
+                if (k1 < 0) {
+                    k1 = k;
+                    count = c;
+                    term = first;
+                    // a shared smallest valuation decides nothing
+                    if (count > 1) break;
+                } else {
+                    k2 = k;
+                }
+            }
+
+            if (k1 < 0) return RHS == 0 ? home.ES_SUBSUMED(*this) : ES_FAILED;
+            // 2^k1 divides every unassigned coefficient
+            if (((unsigned int)RHS & ((1u << k1) - 1)) != 0) return ES_FAILED;
+            if (count > 1) return ES_FIX;
+
+            int val;
+            if (k2 < 0) {
+                // the last term
+                if (RHS == 0) val = 0;
+                else if (RHS == a[term]) val = 1;
+                else return ES_FAILED;
+            } else {
+                const unsigned int mask = (1u << k2) - 1;
+                const unsigned int r = (unsigned int)RHS & mask;
+                if (r == 0) val = 0;
+                else if (r == ((unsigned int)a[term] & mask)) val = 1;
+                else return ES_FAILED;
+            }
+            GECODE_ME_CHECK(x[term].eq(home, val));
+            RHS -= val * a[term];
+            remove(term);
+        }
+    }
+};
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <gecode/int.hh>
+
+#include <climits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+// expects extended_gcd(), pmod() and Mod::ModDomain from modulo_propogator.hpp
+
+// target sizes up to which the reachability check runs, and its work bound in word operations
+#define REACH_LIMIT (1 << 20)
+#define REACH_WORK (1 << 24)
+
+namespace Mod {
+    // equation left after presolving, with the congruence of every term
+    struct Presolve {
+        IntArgs a;
+        IntVarArgs x;
+        int c = 0;
+        std::vector<ModDomain> dom;
+        int divided = 1;        ///< common gcd divided out
+        int folded = 0;         ///< assigned terms folded into c
+        int merged = 0;         ///< duplicate variables merged
+    };
+
+    // initial classes of a presolved equation, kept by the caller between posts of the same equation
+    struct Classes {
+        std::vector<long long> a;   ///< presolved coefficients they belong to
+        long long c = 0;
+        std::vector<ModDomain> dom; ///< empty before the first post
+        bool carried = false;       ///< the last post took them instead of computing them
+    };
+
+    inline long long fdiv(long long a, long long b) {
+        long long q = a / b;
+        return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+    }
+    inline long long cdiv(long long a, long long b) {
+        long long q = a / b;
+        return (a % b != 0 && ((a < 0) == (b < 0))) ? q + 1 : q;
+    }
+
+    // sums of |a_i| * y_i up to t with 0 <= y_i <= w_i as a bitset, bounded knapsack with
+    // multiplicities split in powers of two. Empty when the set is too big to build.
+    inline std::vector<uint64_t> reach_set(const std::vector<long long>& a, const std::vector<long long>& w, long long t) {
+        if (t < 0 || t > REACH_LIMIT) return std::vector<uint64_t>();
+        const size_t words = (size_t)(t >> 6) + 1;
+        long long work = 0;
+        for (size_t i = 0; i < a.size(); i++) {
+            for (long long r = w[i], m = 1; r > 0; r -= m, m <<= 1) work += words;
+            if (work > REACH_WORK) return std::vector<uint64_t>();
+        }
+
+        std::vector<uint64_t> bits(words, 0);
+        bits[0] = 1;
+        for (size_t i = 0; i < a.size(); i++) {
+            const long long ai = a[i] < 0 ? -a[i] : a[i];
+            for (long long r = w[i], m = 1; r > 0; m <<= 1) {
+                const long long k = std::min(m, r);
+                r -= k;
+                const long long sh = ai * k;
+                if (sh > t) break;
+                const size_t ws = (size_t)(sh >> 6);
+                const int bs = (int)(sh & 63);
+                for (size_t j = words; j-- > ws; ) {
+                    uint64_t v = bits[j - ws] << bs;
+                    if (bs != 0 && j > ws) v |= bits[j - ws - 1] >> (64 - bs);
+                    bits[j] |= v;
+                }
+            }
+        }
+        return bits;
+    }
+
+    // is t a sum of |a_i| * y_i with 0 <= y_i <= w_i. Returns true when the check was too big to run.
+    inline bool reachable(const std::vector<long long>& a, const std::vector<long long>& w, long long t) {
+        if (t < 0) return false;
+        const std::vector<uint64_t> bits = reach_set(a, w, t);
+        if (bits.empty()) return true;
+        return (bits[t >> 6] >> (t & 63)) & 1;
+    }
+
+    // is c a x over the bounds of x, y_i = x_i - min for a_i > 0, max - x_i for a_i < 0
+    inline bool reachable(const IntArgs& a, const IntVarArgs& x, long long c) {
+        const size_t n = (size_t)a.size();
+        std::vector<long long> al(n), w(n);
+        long long t = c;
+        for (size_t i = 0; i < n; i++) {
+            al[i] = a[(int)i];
+            w[i] = (long long)x[(int)i].max() - x[(int)i].min();
+            t -= al[i] > 0 ? al[i] * x[(int)i].min() : al[i] * x[(int)i].max();
+        }
+        return reachable(al, w, t);
+    }
+
+    // class of every x_i in a x = c with gcd(a) = 1, a_i is invertible modulo the gcd of the others.
+    // Depends on a and c only, so an equation posted again can keep it, see Classes.
+    inline std::vector<ModDomain> initial_classes(const std::vector<long long>& a, long long c) {
+        const size_t n = a.size();
+        std::vector<ModDomain> d(n, ModDomain());
+        std::vector<long long> suf(n + 1, 0);
+        for (size_t i = n; i-- > 0; ) suf[i] = std::gcd(suf[i + 1], a[i]);
+        long long pre = 0;
+        for (size_t i = 0; i < n; i++) {
+            long long G = std::gcd(pre, suf[i + 1]);
+            pre = std::gcd(pre, a[i]);
+            if (G <= 1) continue;
+            int gg, u, v;
+            std::tie(gg, u, v) = ::extended_gcd(pmod((int)(a[i] % G), (int)G), (int)G);
+            d[i] = ModDomain(pmod((int)((long long)u * pmod((int)(c % G), (int)G) % G), (int)G), (int)G);
+        }
+        return d;
+    }
+
+    // Presolve a x = c, posting what it derives to home. Returns false if the equation does not fit
+    // the int arithmetic used here, p is then left alone. After failure home is failed, and an empty
+    // p.x means nothing is left to post. The initial classes are taken from known if it holds the
+    // same presolved equation, and stored there otherwise. Without reach the knapsack reachability
+    // check is skipped, the caller runs it on p if it wants it.
+    inline bool presolve(Home home, const IntArgs& a0, const IntVarArgs& x0, int c0, Presolve& p, Classes* known = nullptr,
+        bool reach = true) {
+        Space& s = home;
+        if (known != nullptr) known->carried = false;
+
+        // fold assigned variables and merge duplicates
+        std::vector<long long> a;
+        std::vector<IntVar> x;
+        long long c = c0;
+        int folded = 0, merged = 0;
+        std::unordered_map<const void*, size_t> pos;
+        for (int i = 0; i < x0.size(); i++) {
+            if (a0[i] == 0) continue;
+            if (x0[i].assigned()) {
+                c -= (long long)a0[i] * x0[i].val();
+                folded++;
+                continue;
+            }
+            auto it = pos.find(x0[i].varimp());
+            if (it != pos.end()) {
+                a[it->second] += a0[i];
+                merged++;
+            } else {
+                pos[x0[i].varimp()] = a.size();
+                a.push_back(a0[i]);
+                x.push_back(x0[i]);
+            }
+        }
+        // merged coefficients can cancel
+        size_t n = 0;
+        for (size_t i = 0; i < a.size(); i++) {
+            if (a[i] == 0) continue;
+            a[n] = a[i];
+            x[n] = x[i];
+            n++;
+        }
+        a.resize(n);
+        x.resize(n);
+        if (c > INT_MAX || c < INT_MIN) return false;
+        for (long long ai : a) if (ai > INT_MAX || ai < -INT_MAX) return false;
+        p.folded = folded;
+        p.merged = merged;
+
+        if (n == 0) {
+            if (c != 0) s.fail();
+            return true;
+        }
+
+        // divide out the common gcd
+        long long g = 0;
+        for (long long ai : a) g = std::gcd(g, ai);
+        if (c % g != 0) {
+            s.fail();
+            return true;
+        }
+        for (long long& ai : a) ai /= g;
+        c /= g;
+        p.divided = (int)g;
+
+        // bounds, a_i x_i = c - sum_j!=i a_j x_j, any signs
+        for (int round = 0, changed = 1; changed && round < 4; round++) {
+            changed = 0;
+            long long lo = 0, hi = 0;
+            for (size_t i = 0; i < n; i++) {
+                lo += a[i] > 0 ? a[i] * x[i].min() : a[i] * x[i].max();
+                hi += a[i] > 0 ? a[i] * x[i].max() : a[i] * x[i].min();
+            }
+            for (size_t i = 0; i < n; i++) {
+                long long lo_i = a[i] > 0 ? a[i] * x[i].min() : a[i] * x[i].max();
+                long long hi_i = a[i] > 0 ? a[i] * x[i].max() : a[i] * x[i].min();
+                // range of a_i x_i
+                long long l = c - (hi - hi_i);
+                long long u = c - (lo - lo_i);
+                long long xl = a[i] > 0 ? cdiv(l, a[i]) : cdiv(u, a[i]);
+                long long xu = a[i] > 0 ? fdiv(u, a[i]) : fdiv(l, a[i]);
+                if (xl > x[i].max() || xu < x[i].min()) {
+                    s.fail();
+                    return true;
+                }
+                if (xl > x[i].min() || xu < x[i].max()) {
+                    dom(home, x[i], (int)std::max<long long>(xl, x[i].min()), (int)std::min<long long>(xu, x[i].max()));
+                    if (s.failed()) return true;
+                    changed = 1;
+                }
+            }
+        }
+
+        // initial congruences, the gcd of all is 1 now
+        if (known != nullptr && !known->dom.empty() && known->c == c && known->a == a) {
+            p.dom = known->dom;
+            known->carried = true;
+        } else {
+            p.dom = initial_classes(a, c);
+            if (known != nullptr) {
+                known->a = a;
+                known->c = c;
+                known->dom = p.dom;
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            const ModDomain& md = p.dom[i];
+            if (md.mod <= 1) continue;
+            int xl = md.up(x[i].min());
+            int xu = md.down(x[i].max());
+            if (xl > xu) {
+                s.fail();
+                return true;
+            }
+            dom(home, x[i], xl, xu);
+            if (s.failed()) return true;
+        }
+
+        // single term left, it is decided
+        if (n == 1) {
+            rel(home, x[0], IRT_EQ, (int)(c / a[0]));
+            return true;
+        }
+
+        p.a = IntArgs((int)n);
+        p.x = IntVarArgs((int)n);
+        for (size_t i = 0; i < n; i++) {
+            p.a[i] = (int)a[i];
+            p.x[i] = x[i];
+        }
+        p.c = (int)c;
+
+        // reachability, left to the caller when reach is off
+        if (reach && !reachable(p.a, p.x, p.c)) s.fail();
+        return true;
+    }
+};
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <gecode/int.hh>
+#include <gecode/int/linear.hh>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// Sampled per-phase timers
+//   every rate-th entry of a phase is timed, totals are estimated as sampled time * calls / sampled calls.
+//   cpu time is the time of the thread running the phase, so with several search threads every phase
+//   is only credited with its own work (GetThreadTimes on Windows ticks in scheduler quanta, short
+//   phases mostly read 0 there). Linear and branching are timed through Profile::linear and
+//   Profile::branch, which post timed versions while profiling is enabled. Branching includes the
+//   commits replayed by recomputation. What is not covered by a phase (the rest of recomputation,
+//   the engine itself) is reported by the harness as the rest of the run.
+namespace Profile {
+    enum Phase {
+        CLONE_SCRIPT,       ///< Eq20 copy, including the coefficients
+        CLONE_MODULO,       ///< Modulo copies
+        PRINT,              ///< solution output
+        BRANCH,             ///< choice and commit
+        PROP_LINEAR,
+        PROP_MODULO,
+        PROP_MODULO_TER,
+        PROP_MODULO_BOUNDS,
+        PHASES
+    };
+    static const char* const names[PHASES] = {
+        "clone Eq20", "clone Modulo", "print", "branch", "propagate linear",
+        "propagate Modulo", "propagate ModuloTer", "propagate ModuloBounds"
+    };
+
+    // cpu time of the calling thread in ns
+    inline uint64_t thread_cpu(void) {
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) return 0;
+        const uint64_t k = ((uint64_t)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime;
+        const uint64_t u = ((uint64_t)user.dwHighDateTime << 32) | user.dwLowDateTime;
+        // 100 ns ticks
+        return (k + u) * 100;
+#else
+        timespec ts;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+        return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+    }
+
+    struct Counter {
+        std::atomic<uint64_t> calls{ 0 };
+        std::atomic<uint64_t> sampled{ 0 };
+        std::atomic<uint64_t> wall{ 0 };    ///< ns in sampled calls
+        std::atomic<uint64_t> cpu{ 0 };     ///< ns in sampled calls
+    };
+
+    struct State {
+        bool enabled = false;
+        unsigned int rate = 16;             ///< time every rate-th call
+        Counter phase[PHASES];
+    };
+    static State state;
+
+    inline void reset(bool enabled, unsigned int rate) {
+        state.enabled = enabled;
+        state.rate = rate > 0 ? rate : 1;
+        for (Counter& c : state.phase) c.calls = c.sampled = c.wall = c.cpu = 0;
+    }
+
+    // estimated totals in ms
+    inline double wall(Phase p) {
+        const Counter& c = state.phase[p];
+        return c.sampled == 0 ? 0 : 1e-6 * c.wall * ((double)c.calls / c.sampled);
+    }
+    inline double cpu(Phase p) {
+        const Counter& c = state.phase[p];
+        return c.sampled == 0 ? 0 : 1e-6 * c.cpu * ((double)c.calls / c.sampled);
+    }
+
+    class Scope {
+    protected:
+        Counter* c = nullptr;
+        std::chrono::steady_clock::time_point w;
+        uint64_t t = 0;
+    public:
+        Scope(Phase p) {
+            if (!state.enabled) return;
+            Counter& k = state.phase[p];
+            if (k.calls++ % state.rate != 0) return;
+            c = &k;
+            t = thread_cpu();
+            w = std::chrono::steady_clock::now();
+        }
+        ~Scope(void) {
+            if (c == nullptr) return;
+            c->wall += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - w).count();
+            c->cpu += thread_cpu() - t;
+            c->sampled++;
+        }
+    };
+};
+
+#if PROFILE
+#define PROFILE_SCOPE(p) Profile::Scope _profile_scope(p)
+#else
+#define PROFILE_SCOPE(p)
+#endif
+
+namespace Profile {
+    // sum x - sum y = c with bounds propagation as Gecode's linear, timed as PROP_LINEAR.
+    // long long arithmetic as Gecode picks it when int sums could overflow.
+    template <class P, class N>
+    class TimedEq : public Gecode::Int::Linear::Eq<long long, P, N> {
+    protected:
+        using Base = Gecode::Int::Linear::Eq<long long, P, N>;
+        TimedEq(Gecode::Space& home, TimedEq& p) : Base(home, p) {}
+    public:
+        TimedEq(Gecode::Home home, Gecode::ViewArray<P>& x, Gecode::ViewArray<N>& y, long long c) : Base(home, x, y, c) {}
+        virtual Gecode::Actor* copy(Gecode::Space& home) {
+            return new (home) TimedEq(home, *this);
+        }
+        virtual Gecode::ExecStatus propagate(Gecode::Space& home, const Gecode::ModEventDelta& med) {
+            PROFILE_SCOPE(PROP_LINEAR);
+            return Base::propagate(home, med);
+        }
+    };
+
+    // a x = c, timed while profiling is enabled. Domain propagation is left to Gecode untimed.
+    inline void linear(Gecode::Home home, const Gecode::IntArgs& a, const Gecode::IntVarArgs& x, int c, Gecode::IntPropLevel ipl) {
+        using namespace Gecode;
+        if (!PROFILE || !state.enabled || (ipl & IPL_DOM) != 0 || a.size() != x.size()) {
+            Gecode::linear(home, a, x, IRT_EQ, c, ipl);
+            return;
+        }
+        GECODE_POST;
+        int np = 0, nn = 0;
+        for (int i = 0; i < a.size(); i++) {
+            if (a[i] > 0) np++;
+            else if (a[i] < 0) nn++;
+        }
+        ViewArray<Int::LLongScaleView> xp(home, np), yn(home, nn);
+        np = nn = 0;
+        for (int i = 0; i < a.size(); i++) {
+            if (a[i] > 0) xp[np++] = Int::LLongScaleView(a[i], Int::IntView(x[i]));
+            else if (a[i] < 0) yn[nn++] = Int::LLongScaleView(-(long long)a[i], Int::IntView(x[i]));
+        }
+        (void) new (home) TimedEq<Int::LLongScaleView, Int::LLongScaleView>(home, xp, yn, c);
+    }
+    // a x = y
+    inline void linear(Gecode::Home home, const Gecode::IntArgs& a, const Gecode::IntVarArgs& x, Gecode::IntVar y, Gecode::IntPropLevel ipl) {
+        Gecode::IntArgs ay(a);
+        Gecode::IntVarArgs xy(x);
+        ay << -1;
+        xy << y;
+        Profile::linear(home, ay, xy, 0, ipl);
+    }
+
+    // branch(x, INT_VAR_NONE(), INT_VAL_MIN()): the first unassigned variable, x = min or x != min
+    class NoneMin : public Gecode::Brancher {
+    protected:
+        Gecode::ViewArray<Gecode::Int::IntView> x;
+        mutable int start = 0;
+        class PosVal : public Gecode::Choice {
+        public:
+            int pos;
+            int val;
+            PosVal(const NoneMin& b, int p, int v) : Gecode::Choice(b, 2), pos(p), val(v) {}
+            virtual void archive(Gecode::Archive& e) const {
+                Gecode::Choice::archive(e);
+                e << pos << val;
+            }
+        };
+        NoneMin(Gecode::Home home, Gecode::ViewArray<Gecode::Int::IntView>& x0) : Gecode::Brancher(home), x(x0) {}
+        NoneMin(Gecode::Space& home, NoneMin& b) : Gecode::Brancher(home, b), start(b.start) {
+            x.update(home, b.x);
+        }
+    public:
+        static void post(Gecode::Home home, Gecode::ViewArray<Gecode::Int::IntView>& x) {
+            (void) new (home) NoneMin(home, x);
+        }
+        virtual Gecode::Brancher* copy(Gecode::Space& home) {
+            return new (home) NoneMin(home, *this);
+        }
+        virtual bool status(const Gecode::Space&) const {
+            for (int i = start; i < x.size(); i++) {
+                if (!x[i].assigned()) {
+                    start = i;
+                    return true;
+                }
+            }
+            return false;
+        }
+        virtual const Gecode::Choice* choice(Gecode::Space&) {
+            PROFILE_SCOPE(BRANCH);
+            return new PosVal(*this, start, x[start].min());
+        }
+        virtual const Gecode::Choice* choice(const Gecode::Space&, Gecode::Archive& e) {
+            int pos, val;
+            e >> pos >> val;
+            return new PosVal(*this, pos, val);
+        }
+        virtual Gecode::ExecStatus commit(Gecode::Space& home, const Gecode::Choice& c, unsigned int a) {
+            PROFILE_SCOPE(BRANCH);
+            const PosVal& pv = static_cast<const PosVal&>(c);
+            return Gecode::me_failed(a == 0 ? x[pv.pos].eq(home, pv.val) : x[pv.pos].nq(home, pv.val))
+                ? Gecode::ES_FAILED : Gecode::ES_OK;
+        }
+        virtual void print(const Gecode::Space&, const Gecode::Choice& c, unsigned int a, std::ostream& o) const {
+            const PosVal& pv = static_cast<const PosVal&>(c);
+            o << "x[" << pv.pos << "] " << (a == 0 ? "=" : "!=") << " " << pv.val;
+        }
+        virtual size_t dispose(Gecode::Space& home) {
+            (void) Gecode::Brancher::dispose(home);
+            return sizeof(*this);
+        }
+    };
+
+    // branch(x, INT_VAR_NONE(), INT_VAL_MIN()), timed while profiling is enabled
+    inline void branch(Gecode::Home home, const Gecode::IntVarArgs& x) {
+        using namespace Gecode;
+        if (!PROFILE || !state.enabled) {
+            Gecode::branch(home, x, INT_VAR_NONE(), INT_VAL_MIN());
+            return;
+        }
+        if (home.failed()) return;
+        ViewArray<Int::IntView> xv(home, x);
+        NoneMin::post(home, xv);
+    }
+};
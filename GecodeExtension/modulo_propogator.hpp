@@ -4,6 +4,11 @@
 
 #include <vector>
 #include <tuple>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <numeric>
+#include <chrono>
 
 #include "PrettyText.h"
 
@@ -14,6 +19,19 @@
 #define LIMIT_DOMAIN false
 #define ADV_MOD false
 #define DBL_BOUND false
+// back off while propagation prunes nothing
+#define ADAPTIVE true
+// unproductive runs before backing off, and the largest number of skipped wake-ups
+#define ADAPT_PATIENCE 4
+#define ADAPT_MAX 64
+// memoize the congruence structure per unassigned set
+#define MEMO true
+// entries per equation before the cache is flushed
+#define MEMO_LIMIT 4096
+// fold, merge, divide and bound the equation before posting
+#define PRESOLVE true
+// sampled timers around propagation and cloning, enabled at runtime by the harness
+#define PROFILE true
 
 // enums weren't doing highlighting, sooooo....
 // 0 == set
@@ -49,6 +67,9 @@ inline int pmod(int a, int b) {
     return ((a % b) + b) % b;
 }
 
+#include "modulo_analysis.hpp"
+#include "modulo_profile.hpp"
+
 namespace Mod {
     // struct for mod domains
     struct ModDomain {
@@ -56,14 +77,25 @@ namespace Mod {
         int mod;
         ModDomain(int _off, int _mod) : off(_off), mod(_mod) {};
         ModDomain() : off(0), mod(1) {};
+
+        // same class with a positive modulus and 0 <= off < mod
+        ModDomain normal(void) const {
+            int m = mod < 0 ? -mod : mod;
+            return ModDomain(pmod(off, m), m);
+        }
+        // nearest congruent values above and below v, floored so negative v work (mod > 0)
+        int up(int v) const { return v + pmod(off - v, mod); }
+        int down(int v) const { return v - pmod(v - off, mod); }
     };
 
 
-    class ModTerm : public Int::Linear::Term<Int::IntView> {
+    // a*x term over any integer view, as the terms of Gecode's linear propagators
+    template <class View>
+    class ModTerm : public Int::Linear::Term<View> {
     public:
-        using Int::Linear::Term<Int::IntView>::x;
-        using Int::Linear::Term<Int::IntView>::p;
-        using Int::Linear::Term<Int::IntView>::a;
+        using Int::Linear::Term<View>::x;
+        using Int::Linear::Term<View>::p;
+        using Int::Linear::Term<View>::a;
         ModDomain modDom;
     public:
         // View
@@ -97,17 +129,132 @@ namespace Mod {
     };
 };
 
-using TView = Mod::ModTerm;
-using TArray = ViewArray<Mod::ModTerm>;
+using TView = Mod::ModTerm<Int::IntView>;
+using TArray = ViewArray<TView>;
 using NProp = NaryPropagator<TView, Int::PC_INT_VAL>;
-using NPropDom = NaryPropagator<TView, Int::PC_INT_DOM>;
+
+#include "modulo_presolve.hpp"
 
 namespace Mod {
     // struct for modulo information
+    template <class Term>
     struct ModInfo {
-        TView* ax;
+        Term* ax;
         int g;
-        ModInfo(TView& _ax, int _g) : ax(&_ax), g(_g) {};
+        ModInfo(Term& _ax, int _g) : ax(&_ax), g(_g) {};
+    };
+
+
+    // congruence data of an unassigned term that does not depend on RHS
+    struct ModCongruence {
+        int i;      ///< position in the term array
+        int b;      ///< gcd of the other unassigned coefficients, INT_MAX if there are none
+        int g;      ///< gcd(a, b) as returned by extended_gcd
+        int u;      ///< Bezout coefficient of a
+        ModCongruence(int _i, int _b, int _g, int _u) : i(_i), b(_b), g(_g), u(_u) {};
+    };
+
+    // what the pruning stage derives from the set of unassigned terms
+    struct ModCongruences {
+        int g = INT_MAX;                    ///< gcd of the unassigned coefficients
+        std::vector<ModCongruence> terms;   ///< terms with a gcd of the others > 1
+    };
+
+    // Congruence cache of one posted equation, kept outside the space so every clone
+    // and every search thread shares it. Keys are bitsets of the unassigned positions.
+    class ModCache : public SharedHandle {
+    protected:
+        class Object : public SharedHandle::Object {
+        public:
+            Support::Mutex m;
+            size_t limit;
+            std::unordered_map<std::string, std::shared_ptr<const ModCongruences>> map;
+            unsigned long int hits = 0;
+            unsigned long int misses = 0;
+            Object(size_t _limit) : limit(_limit) {}
+        };
+        Object* cache(void) const {
+            return static_cast<Object*>(object());
+        }
+    public:
+        ModCache(void) {}
+        explicit ModCache(size_t limit) : SharedHandle(new Object(limit)) {}
+
+        // congruences for signature sig, computed with f on a miss
+        template <class F>
+        std::shared_ptr<const ModCongruences> get(const std::string& sig, F f) const {
+            Object* o = cache();
+            {
+                Support::Lock l(o->m);
+                auto it = o->map.find(sig);
+                if (it != o->map.end()) {
+                    o->hits++;
+                    return it->second;
+                }
+                o->misses++;
+            }
+            // computed outside the lock, a racing thread computes the same entry
+            std::shared_ptr<const ModCongruences> e = std::make_shared<const ModCongruences>(f());
+            Support::Lock l(o->m);
+            // bounded, entries in use stay alive through their shared_ptr
+            if (o->map.size() >= o->limit) o->map.clear();
+            o->map.emplace(sig, e);
+            return e;
+        }
+        bool valid(void) const { return object() != NULL; }
+        unsigned long int hits(void) const { return cache()->hits; }
+        unsigned long int misses(void) const { return cache()->misses; }
+    };
+
+    // What an equation keeps between posts over growing boxes: the initial classes of the presolved
+    // equation, and the congruence memo of its Modulo. The memo depends on the coefficients only, so
+    // it stays valid as long as the classes are carried.
+    struct Carry {
+        Classes classes;
+        ModCache memo;
+    };
+
+    // Congruences per term position, local to a space but shared by the propagators of one equation,
+    // so classes found by Modulo are seen by ModuloBounds after cloning as well
+    class ModTable : public LocalHandle {
+    protected:
+        class Object : public LocalObject {
+        public:
+            int n;
+            ModDomain* dom;
+            Object(Home home, int _n)
+                : LocalObject(home), n(_n) {
+                dom = static_cast<Space&>(home).alloc<ModDomain>(n);
+            }
+            Object(Space& home, Object& o)
+                : LocalObject(home, o), n(o.n), dom(home.alloc<ModDomain>(o.n)) {
+                for (int i = 0; i < n; i++) dom[i] = o.dom[i];
+            }
+            virtual Actor* copy(Space& home) {
+                return new (home) Object(home, *this);
+            }
+        };
+        Object* table(void) const {
+            return static_cast<Object*>(object());
+        }
+    public:
+        ModTable(void) {}
+        ModTable(Home home, int n) : LocalHandle(new (home) Object(home, n)) {}
+        ModTable(const ModTable& t) : LocalHandle(t) {}
+        ModTable& operator =(const ModTable& t) {
+            LocalHandle::operator =(t);
+            return *this;
+        }
+        bool valid(void) const { return object() != NULL; }
+        const ModDomain& operator [](int i) const { return table()->dom[i]; }
+        void set(int i, const ModDomain& d) { table()->dom[i] = d.normal(); }
+    };
+
+    // Congruences of one posted equation for the model, position k of the table holds the class of
+    // the model's x[var[k]]. The table is invalid when the equation went to linear.
+    struct Published {
+        ModTable table;
+        std::vector<int> var;   ///< index in the model's x per position, -1 for none
     };
 
 
@@ -125,17 +272,14 @@ namespace Mod {
         int md;
         int off;
     private:
+        // floored, so negative m snap to the right value as in ModDomain::down and up
         int lastMod(int m) const {
-            // get last multiple of mod from m
-            return (m - off) % mod == 0
-                ? m
-                : ((m - off + md) / mod) * mod + off - mod;
+            // get last value of the class at or below m
+            return m - pmod(m - off, mod);
         }
         int nextMod(int m) const {
-            // get next multiple of mod from m
-            return (m - off) % mod == 0
-                ? m
-                : ((m - off + md) / mod) * mod + off;
+            // get next value of the class at or above m
+            return m + pmod(off - m, mod);
             //return (m | md) + 1; powers of 2 only
         }
 
@@ -153,7 +297,8 @@ namespace Mod {
         /// x = n % m
         ModInter(int _off, int _mod, int _min, int _max);
         ModInter(const ModInter& other);
-        ModInter(const TView* t);
+        template <class Term>
+        ModInter(const Term* t);
         /// Initialize with value iterator \a i
         void init(const I& i0);
         //@}
@@ -206,8 +351,9 @@ namespace Mod {
     {}
 
     template <class I>
+    template <class Term>
     forceinline
-        ModInter<I>::ModInter(const TView* t)
+        ModInter<I>::ModInter(const Term* t)
         : off(t->modDom.off),
         mod(t->modDom.mod),
         md(t->modDom.mod - 1)
@@ -235,9 +381,9 @@ namespace Mod {
     template <class I>
     forceinline void
     ModInter<I>::init(const I& i0) {
-        n = lastMod(i0.min()) + off;
+        n = nextMod(i0.min());
         start = n;
-        end = nextMod(i0.max());
+        end = lastMod(i0.max());
     }
 
     template <class I>
@@ -257,47 +403,263 @@ namespace Mod {
         return n;
     }
 
+    // class of x in a x + b y = r, false if there is no integer solution
+    inline bool congruence(long long a, long long b, long long r, ModDomain& d) {
+        long long g = std::gcd(a, b);
+        if (r % g != 0) return false;
+        long long m = (b < 0 ? -b : b) / g;
+        d = ModDomain();
+        if (m == 1) return true;
+        int gg, u, v;
+        std::tie(gg, u, v) = ::extended_gcd(pmod((int)(a / g % m), (int)m), (int)m);
+        long long off = (long long)u * ((r / g) % m) % m;
+        d = ModDomain((int)(off < 0 ? off + m : off), (int)m);
+        return true;
+    }
+
+    // intersect the classes x = p and x = q into d by the Chinese remainder theorem, false if they
+    // are disjoint. When the combined modulus does not fit an int the larger one is kept.
+    inline bool crt(const ModDomain& p, const ModDomain& q, ModDomain& d) {
+        const ModDomain s = p.normal(), t = q.normal();
+        const long long g = std::gcd((long long)s.mod, (long long)t.mod);
+        if ((t.off - s.off) % g != 0) return false;
+        const long long m = (long long)s.mod / g * t.mod;
+        if (m > Int::Limits::max) {
+            d = s.mod >= t.mod ? s : t;
+            return true;
+        }
+        // s.off + s.mod k with k = (t.off - s.off) / g * (s.mod / g)^-1 mod t.mod / g
+        const long long n = t.mod / g;
+        long long k = 0;
+        if (n > 1) {
+            int gg, u, v;
+            std::tie(gg, u, v) = ::extended_gcd(pmod((int)(s.mod / g % n), (int)n), (int)n);
+            k = ((t.off - s.off) / g % n) * u % n;
+            if (k < 0) k += n;
+        }
+        d = ModDomain((int)((s.off + s.mod * k) % m), (int)m);
+        return true;
+    }
+
+    // snap the pair a_0 x_0 + a_1 x_1 = r to the classes x_i = (a_i / g)^-1 (r / g) mod |a_j| / g,
+    // publishing them to t if it is valid. p holds the positions of the terms in t.
+    template <class View>
+    ExecStatus snap_pair(Space& home, View* v, const int* a, const int* p, long long r, ModTable& t) {
+        for (int k = 0; k < 2; k++) {
+            ModDomain d;
+            if (!congruence(a[k], a[1 - k], r, d)) return ES_FAILED;
+            if (d.mod == 1) continue;
+            if (t.valid()) t.set(p[k], d);
+            int lo = d.up(v[k].min());
+            int hi = d.down(v[k].max());
+            if (lo > hi) return ES_FAILED;
+            GECODE_ME_CHECK(v[k].gq(home, lo));
+            GECODE_ME_CHECK(v[k].lq(home, hi));
+        }
+        return ES_OK;
+    }
+
+    // snap the triple a_0 x_0 + a_1 x_1 + a_2 x_2 = r to the classes a_k x_k = r modulo the gcd of the
+    // other two coefficients, publishing them to t if it is valid. p holds the positions in t.
+    template <class View>
+    ExecStatus snap_triple(Space& home, View* v, const int* a, const int* p, long long r, ModTable& t) {
+        for (int k = 0; k < 3; k++) {
+            ModDomain d;
+            if (!congruence(a[k], std::gcd(a[(k + 1) % 3], a[(k + 2) % 3]), r, d)) return ES_FAILED;
+            if (d.mod == 1) continue;
+            if (t.valid()) t.set(p[k], d);
+            int lo = d.up(v[k].min());
+            int hi = d.down(v[k].max());
+            if (lo > hi) return ES_FAILED;
+            GECODE_ME_CHECK(v[k].gq(home, lo));
+            GECODE_ME_CHECK(v[k].lq(home, hi));
+        }
+        return ES_OK;
+    }
+
+    // Modulo over its last three terms. Their classes are snapped by Modulo::ternary before rewriting and
+    // stay the same until one of them is assigned, so it only wakes on assignments, snaps the pair left to
+    // its classes once and is subsumed.
+    template <class View>
+    class ModuloTer : public TernaryPropagator<View, Int::PC_INT_VAL> {
+    protected:
+        using Base = TernaryPropagator<View, Int::PC_INT_VAL>;
+        using Base::x0;
+        using Base::x1;
+        using Base::x2;
+        int a[3];
+        int p[3];           ///< positions in the table of the rewritten propagator
+        int RHS;
+        ModTable bounds;    ///< congruences published to ModuloBounds, if posted
+
+        ModuloTer(Home home, View y0, View y1, View y2, const int* _a, const int* _p, int c, ModTable t)
+            : Base(home, y0, y1, y2), RHS(c), bounds(t) {
+            for (int i = 0; i < 3; i++) {
+                a[i] = _a[i];
+                p[i] = _p[i];
+            }
+        }
+        ModuloTer(Space& home, ModuloTer& q)
+            : Base(home, q), RHS(q.RHS) {
+            for (int i = 0; i < 3; i++) {
+                a[i] = q.a[i];
+                p[i] = q.p[i];
+            }
+            if (q.bounds.valid()) bounds.update(home, q.bounds);
+        }
+    public:
+        virtual Actor* copy(Space& home) {
+            return new (home) ModuloTer(home, *this);
+        }
+        virtual ExecStatus propagate(Space& home, const ModEventDelta& med);
+        static ExecStatus post(Home home, View y0, View y1, View y2, const int* a, const int* p, int c, ModTable t) {
+            (void) new (home) ModuloTer(home, y0, y1, y2, a, p, c, t);
+            return ES_OK;
+        }
+    };
+
+    template <class View>
+    ExecStatus ModuloTer<View>::propagate(Space& home, const ModEventDelta&) {
+        PROFILE_SCOPE(Profile::PROP_MODULO_TER);
+        View v[3] = { x0, x1, x2 };
+        int live[3];
+        int n = 0;
+        long long r = RHS;
+        for (int i = 0; i < 3; i++) {
+            if (v[i].assigned()) r -= (long long)a[i] * v[i].val();
+            else live[n++] = i;
+        }
+        if (n == 3) return ES_FIX;
+        if (n == 0) return r == 0 ? home.ES_SUBSUMED(*this) : ES_FAILED;
+        if (n == 1) {
+            if (r % a[live[0]] != 0) return ES_FAILED;
+            GECODE_ME_CHECK(v[live[0]].eq(home, (int)(r / a[live[0]])));
+            return home.ES_SUBSUMED(*this);
+        }
+
+        // the pair left
+        View pv[2] = { v[live[0]], v[live[1]] };
+        int pa[2] = { a[live[0]], a[live[1]] };
+        int pp[2] = { p[live[0]], p[live[1]] };
+        GECODE_ES_CHECK(snap_pair(home, pv, pa, pp, r, bounds));
+        // the last term left is decided by linear
+        return home.ES_SUBSUMED(*this);
+    }
+
     //             Array | a*x terms | Propagate on View Assignment
-    class Modulo : public NProp {
+    //   View is any integer view, ModTerm<View> the term type, as in Gecode's linear propagators. Only
+    //   IntView is posted so far, Boolean equations go through ModuloBool or through Modulo on channelled
+    //   IntVars
+    template <class View>
+    class Modulo : public NaryPropagator<ModTerm<View>, Int::PC_INT_VAL> {
     protected:
+        using Term = ModTerm<View>;
+        using Terms = ViewArray<Term>;
+        using NProp = NaryPropagator<Term, Int::PC_INT_VAL>;
         using NProp::x;
         int RHS;
 
+        // congruence cache, shared with every clone
+        ModCache memo;
+        // congruences published to ModuloBounds, if posted
+        ModTable bounds;
+
+        // adaptivity
+        int unproductive = 0;   ///< unproductive runs in a row
+        int backoff = 0;        ///< wake-ups skipped per run while backed off
+        int skip = 0;           ///< wake-ups left to skip
+        int live = 0;           ///< unassigned terms when backing off
+
         // Constructors
         // Construct Propagator
-        Modulo(Home home, TArray ax, int y)
-            : NProp(home, ax), RHS(y) {}
+        Modulo(Home home, Terms ax, int y, ModTable t = ModTable(), ModCache m = ModCache())
+            : NProp(home, ax), RHS(y), memo(m.valid() ? m : ModCache(MEMO_LIMIT)), bounds(t) {
+            home.notice(*this, AP_DISPOSE);
+        }
         // Clone Propagator
         Modulo(Space& home, Modulo& p)
-            : NProp(home, p), RHS(p.RHS) {}
+            : NProp(home, p), RHS(p.RHS), memo(p.memo),
+            unproductive(p.unproductive), backoff(p.backoff), skip(p.skip), live(p.live) {
+            if (p.bounds.valid()) bounds.update(home, p.bounds);
+        }
+
+        // record whether a run pruned, backing off or reactivating
+        void adapt(bool pruned);
+
+        // stages
+        // fold assignments into RHS and check divisibility by the gcd
+        ExecStatus fold(Space& home);
+        // congruence reasoning and domain pruning
+        ExecStatus prune(Space& home);
+        // gcd structure of the unassigned terms
+        ModCongruences congruences(void) const;
+        // snap the classes of the three terms left and rewrite into ModuloTer
+        ExecStatus ternary(Space& home);
     public:
-        // Constructor for rewriting p during cloning
-        Modulo(Space& home, Propagator& p, TArray& ax, int y)
-            : NProp(home, p, ax), RHS(y) {};
+        // Dispose propagator, releasing the cache
+        virtual size_t dispose(Space& home);
 
         // Copy propagator during cloning
         virtual Actor* copy(Space& home);
         // Perform propagation
         virtual ExecStatus propagate(Space& home, const ModEventDelta& med);
         // Post propagator
-        static  ExecStatus post(Space& home, TArray& ax, IntRelType irt, int c);
+        static  ExecStatus post(Space& home, Terms& ax, IntRelType irt, int c, ModTable t = ModTable(), ModCache m = ModCache());
 
         // cost function
         virtual PropCost cost(const Space& home, const ModEventDelta& med) const override;
     };
 
-    // cost, lie to make this go first
-    PropCost Modulo::cost(const Space&, const ModEventDelta&) const {
-        return PropCost::unary(PropCost::LO);
+    // cost, the folding stage is a single pass, the pruning stage updates a gcd per term for every term
+    template <class View>
+    PropCost Modulo<View>::cost(const Space&, const ModEventDelta& med) const {
+        if (View::me(med) == Int::ME_INT_VAL)
+            return PropCost::linear(PropCost::LO, x.size());
+#if ADAPTIVE
+        if (backoff > 0)
+            return PropCost::quadratic(PropCost::HI, x.size());
+#endif
+        return PropCost::quadratic(PropCost::LO, x.size());
+    }
+
+    // Adaptivity
+    template <class View>
+    void Modulo<View>::adapt(bool pruned) {
+#if ADAPTIVE
+        if (pruned) {
+            unproductive = backoff = skip = 0;
+            return;
+        }
+        if (++unproductive >= ADAPT_PATIENCE) {
+            // double the skipped wake-ups each time it stays unproductive
+            backoff = std::min(backoff == 0 ? 1 : 2 * backoff, ADAPT_MAX);
+            skip = backoff;
+            unproductive = 0;
+            live = 0;
+            for (Term const& ax_i : x) if (!ax_i.x.assigned()) live++;
+        }
+#endif
     }
 
     // Copy
-    Actor* Modulo::copy(Space& home) {
+    template <class View>
+    Actor* Modulo<View>::copy(Space& home) {
+        PROFILE_SCOPE(Profile::CLONE_MODULO);
         return new (home) Modulo(home, *this);
     }
 
+    // Dispose
+    template <class View>
+    size_t Modulo<View>::dispose(Space& home) {
+        home.ignore(*this, AP_DISPOSE);
+        memo.~ModCache();
+        (void) NProp::dispose(home);
+        return sizeof(*this);
+    }
+
     // Post
-    ExecStatus Modulo::post(Space& home, TArray& ax, IntRelType irt, int c) {
+    template <class View>
+    ExecStatus Modulo<View>::post(Space& home, Terms& ax, IntRelType irt, int c, ModTable t, ModCache m) {
         // Fail on empty terms
         if (ax.size() == 0)
             return ES_FAILED;
@@ -318,7 +680,7 @@ namespace Mod {
         // test if no propagator needs to be posted
         if (!ax.assigned()) {
             // post propagator
-            (void) new (home) Modulo(home, ax, c);
+            (void) new (home) Modulo(home, ax, c, t, m);
 
         }
 
@@ -328,7 +690,170 @@ namespace Mod {
 
 
     // Propagate
-    ExecStatus Modulo::propagate(Space& home, const ModEventDelta& modEv) {
+    //   assignments only wake the folding stage, which schedules the pruning stage
+    //   with ME_INT_DOM so it runs after the cheaper propagators reached their fixpoint
+    template <class View>
+    ExecStatus Modulo<View>::propagate(Space& home, const ModEventDelta& modEv) {
+        PROFILE_SCOPE(Profile::PROP_MODULO);
+        if (View::me(modEv) == Int::ME_INT_VAL)
+            return fold(home);
+        return prune(home);
+    }
+
+    // Folding stage
+    template <class View>
+    ExecStatus Modulo<View>::fold(Space& home) {
+        int g = INT_MAX;
+        int n_live = 0;
+        for (Term& ax_i : x) {
+            if (ax_i.x.assigned()) {
+                if (ax_i.a != 0) {
+                    // reduce right side by coefficient * variable
+                    RHS -= ax_i.a * ax_i.x.val();
+                    ax_i.a = 0;
+#if DEBUG
+                    // print out assignment
+                    std::stringstream os;
+                    os << "x" << ax_i.p << " assigned to " << ax_i.x;
+                    PP(os.str(), { TextF::BOLD, TextF::C_MAGENTA });
+                    // print out RHS
+                    std::cout << COL_1 << "RHS == " << RHS << std::endl;
+#endif
+                }
+            } else {
+                g = gcd(g, ax_i.a);
+                n_live++;
+            }
+        }
+
+        // solution check
+        if (n_live == 0) return RHS == 0 ? home.ES_SUBSUMED(*this) : ES_FAILED;
+        if (n_live == 1) {
+            for (Term& ax_i : x) {
+                if (ax_i.x.assigned()) continue;
+                if (RHS % ax_i.a != 0) return ES_FAILED;
+                GECODE_ME_CHECK(ax_i.x.eq(home, RHS / ax_i.a));
+            }
+            return home.ES_SUBSUMED(*this);
+        }
+
+        // check for failure
+        if (g == 1) {
+            // a pair is snapped to its classes once, as in ModuloTer, which stay until one of them is
+            // assigned and linear decides the other. A triple only needs the ternary form.
+            if (n_live == 2) {
+                View pv[2];
+                int pa[2], pp[2];
+                int k = 0;
+                for (int i = 0; i < x.size(); i++) {
+                    if (x[i].x.assigned()) continue;
+                    pv[k] = x[i].x;
+                    pa[k] = x[i].a;
+                    pp[k] = i;
+                    k++;
+                }
+                GECODE_ES_CHECK(snap_pair(home, pv, pa, pp, RHS, bounds));
+                return home.ES_SUBSUMED(*this);
+            }
+            if (n_live == 3) return ternary(home);
+            adapt(false);
+            return ES_FIX;
+        }
+        if (RHS % g != 0) return ES_FAILED; //fail
+
+#if ADAPTIVE
+        // backed off, skip the pruning stage unless the equation shrank to half since backing off.
+        // the last three terms are always pruned, as that ends in subsumption or rewriting.
+        if (skip > 0 && n_live > 3) {
+            if (n_live > live / 2) {
+                skip--;
+                return ES_FIX;
+            }
+            // conditions changed, try again with a clean slate
+            backoff = skip = unproductive = 0;
+        }
+#endif
+        return home.ES_FIX_PARTIAL(*this, View::med(Int::ME_INT_DOM));
+    }
+
+    // Rewriting, terms assigned during the last run are folded by ModuloTer
+    template <class View>
+    ExecStatus Modulo<View>::ternary(Space& home) {
+        View v[3];
+        int a[3], p[3];
+        int k = 0;
+        for (int i = 0; i < x.size() && k < 3; i++) {
+            if (x[i].a == 0) continue;
+            v[k] = x[i].x;
+            a[k] = x[i].a;
+            p[k] = i;
+            k++;
+        }
+        int c = RHS;
+        ModTable t = bounds;
+        // the triple's classes, fold rewrites without a pruning run before. With a term assigned during
+        // the last run ModuloTer is scheduled at once and snaps the pair left.
+        if (!v[0].assigned() && !v[1].assigned() && !v[2].assigned())
+            GECODE_ES_CHECK(snap_triple(home, v, a, p, c, t));
+        GECODE_REWRITE(*this, ModuloTer<View>::post(home(*this), v[0], v[1], v[2], a, p, c, t));
+    }
+
+    // gcd structure of the unassigned terms
+    template <class View>
+    ModCongruences Modulo<View>::congruences(void) const {
+        ModCongruences cg;
+        std::vector<ModInfo<Term>> l;
+        // for each unassigned variable
+        for (Term const &ax_i : x) {
+            if (ax_i.x.assigned()) continue;
+
+            // update gcd of old terms
+            for (ModInfo<Term>& _l : l) {
+                _l.g = gcd(_l.g, ax_i.a);
+            }
+
+            // add current
+            l.push_back(ModInfo<Term>(const_cast<Term&>(ax_i), cg.g));
+
+            // remove those where gcd == 1
+            l.erase(
+                std::remove_if(
+                    l.begin(),
+                    l.end(),
+                    [](const ModInfo<Term> &element) -> bool {
+                        return element.g <= 1;
+                    }
+                ),
+                l.end()
+            );
+
+            // update gcd
+            cg.g = gcd(cg.g, ax_i.a);
+#if DEBUG
+            // print out GCD
+            std::cout << "gcd == " << cg.g << COL_1
+            // print out modInfo array
+                << "[";
+            for (ModInfo<Term> const & _l : l) {
+                std::cout << "(" << _l.ax->a << " * x" << _l.ax->p << ", " << _l.g << ") ";
+            }
+            std::cout << "]" << std::endl;
+#endif
+        }
+
+        // bezouts, only the RHS dependent part is left to the pruning stage
+        for (ModInfo<Term> const &_l : l) {
+            int g = 0, u = 0, v;
+            if (_l.g != INT_MAX)
+                std::tie(g, u, v) = ::extended_gcd(_l.ax->a, _l.g);
+            cg.terms.push_back(ModCongruence((int)(_l.ax - &x[0]), _l.g, g, u));
+        }
+        return cg;
+    }
+
+    // Pruning stage
+    template <class View>
+    ExecStatus Modulo<View>::prune(Space& home) {
 #if DEBUG
         // print out inital RHS
         std::cout << std::endl;
@@ -338,14 +863,15 @@ namespace Mod {
         std::cout << COL_1 << "RHS == " << RHS << std::endl;
 #endif
         // init vars
-        int g = INT_MAX;
-        std::vector<ModInfo> l;
-        int n = x.size();
+        bool pruned = false;
+        int n_live = 0;
+        std::string sig((x.size() + 7) / 8, 0);
         // for each variable
-        for (ModTerm &ax_i : x) {
+        for (int i = 0; i < x.size(); i++) {
+            Term& ax_i = x[i];
             // reduce RHS by newly assigned vars
             if (ax_i.x.assigned()) {
-                if (ax_i.x.assigned() && ax_i.a != 0) {
+                if (ax_i.a != 0) {
                     // reduce right side by coefficient * variable
                     RHS -= ax_i.a * ax_i.x.val();
                     ax_i.a = 0;
@@ -360,51 +886,34 @@ namespace Mod {
                 }
             // if variable not set
             } else {
-                // update gcd of old terms
-                for (ModInfo& _l : l) {
-                    _l.g = gcd(_l.g, ax_i.a);
-                }
-
-                // add current
-                l.push_back(ModInfo(ax_i, g));
-
-                // remove those where gcd == 1
-                l.erase(
-                    std::remove_if(
-                        l.begin(),
-                        l.end(),
-                        [](const ModInfo &element) -> bool {
-                            return element.g <= 1;
-                        }
-                    ),
-                    l.end()
-                );
-
-                // update gcd
-                g = gcd(g, ax_i.a);
-#if DEBUG
-                // print out GCD
-                std::cout << "gcd == " << g << COL_1
-                // print out modInfo array
-                    << "[";
-                for (ModInfo const & _l : l) {
-                    std::cout << "(" << _l.ax->a << " * x" << _l.ax->p << ", " << _l.g << ") ";
-                }
-                std::cout << "]" << std::endl;
-#endif
+                sig[i >> 3] |= (char)(1 << (i & 7));
+                n_live++;
             }
         }
+
+        // the gcd structure only depends on which terms are unassigned
+#if MEMO
+        std::shared_ptr<const ModCongruences> cg = memo.get(sig, [this]() { return congruences(); });
+#else
+        std::shared_ptr<const ModCongruences> cg = std::make_shared<const ModCongruences>(congruences());
+#endif
+        int g = cg->g;
         
         // check for failure
-        if (g == 1) return ES_FIX;
+        if (g == 1) {
+            adapt(false);
+            return ES_FIX;
+        }
         if (RHS % g != 0) return ES_FAILED; //fail
 
         // propagate
-        for (ModInfo const &_l : l) {
+        for (ModCongruence const &ct : cg->terms) {
+            ModInfo<Term> _l(x[ct.i], ct.b);
             int a, b, c, g, u, v, bg, ucg, m, n;
 
             if (_l.g == INT_MAX) {
-                _l.ax->x.eq(home, RHS / _l.ax->a);
+                GECODE_ME_CHECK(_l.ax->x.eq(home, RHS / _l.ax->a));
+                pruned = true;
                 continue;
             }
 
@@ -414,7 +923,8 @@ namespace Mod {
             c = pmod(RHS, b);
 
             // bezouts
-            std::tie(g, u, v) = ::extended_gcd(a, b);
+            g = ct.g;
+            u = ct.u;
 
             // out ModInfo
             bg = b / g;
@@ -485,12 +995,15 @@ namespace Mod {
 
                 // intersect domain with modulus constraint
                 _l.ax->modDom = ModDomain(ucg, bg);
-                auto i = ModInter<Int::IntView>(_l.ax);
+                if (bounds.valid()) bounds.set(ct.i, _l.ax->modDom);
+                unsigned int size = _l.ax->x.size();
+                auto i = ModInter<View>(_l.ax);
 #if DOM_TYPE == 0
                 _l.ax->x.inter_v(home, i, true);
                 mod(home, _l.ax->x, IntVar(home, ucg, ucg), IntVar(home, bg, bg));
 #elif DOM_TYPE == 1
-                dom(home, _l.ax->x, i.min(), i.max());
+                GECODE_ME_CHECK(_l.ax->x.gq(home, i.min()));
+                GECODE_ME_CHECK(_l.ax->x.lq(home, i.max()));
 #endif
 
                 // fail if domain is empty.
@@ -501,6 +1014,7 @@ namespace Mod {
 #endif
                     return ES_FAILED;
                 }
+                if (_l.ax->x.size() < size) pruned = true;
 
 
 #if DEBUG
@@ -519,7 +1033,11 @@ namespace Mod {
         }
 
         // return solution found if all x_i are assigned
-        if (x.assigned()) return ES_OK;
+        if (x.assigned()) return home.ES_SUBSUMED(*this);
+
+        // a pair has its classes now and the last term is left to linear, a triple moves to ModuloTer
+        if (n_live <= 2) return home.ES_SUBSUMED(*this);
+        if (n_live == 3) return ternary(home);
 
 #if SHORT_CIRCUIT
         bool short_circuit = true;
@@ -527,7 +1045,7 @@ namespace Mod {
         int fulfill_only = -1;
         // if there is term that can be set to make RHS 0, and everything else can be set to 0
         // for each term
-        for (ModTerm& ax_i : x) {
+        for (Term& ax_i : x) {
             // if its unassigned
             if (!ax_i.x.assigned()) {
                 // if it can make RHS 0
@@ -566,7 +1084,7 @@ namespace Mod {
             _ax->x.eq(home, RHS / _ax->a);
                
             // set all others to 0
-            for (ModTerm& ax_i : x) {
+            for (Term& ax_i : x) {
                 if (!ax_i.x.assigned()) {
                      ax_i.x.eq(home, 0);
                 }
@@ -578,6 +1096,7 @@ namespace Mod {
 #if DEBUG
         PP("End Propagation", {TextF::DC_CYAN});
 #endif
+        adapt(pruned);
         // otherwise return a fixpoint, the propagator only needs to run once per variable assignment
         return ES_FIX;
     }
@@ -585,46 +1104,82 @@ namespace Mod {
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////////////////////////////
     // Propagator for bounds update
-    //             Array | a*x terms | Propagate on Domain Change
-    class ModuloDomain : public NPropDom {
+    //   advisors collect the terms whose bounds changed, propagation snaps only those
+    //   to the nearest values in their congruence class
+    class ModuloBounds : public Propagator {
     protected:
-        using NPropDom::x;
+        // advisor remembering the term position
+        class ModAdvisor : public Advisor {
+        public:
+            int i;
+            ModAdvisor(Space& home, Propagator& p, Council<ModAdvisor>& c, int _i)
+                : Advisor(home, p, c), i(_i) {}
+            ModAdvisor(Space& home, ModAdvisor& a)
+                : Advisor(home, a), i(a.i) {}
+        };
+
+        TArray x;
+        ModTable table;
+        Council<ModAdvisor> c;
+        int* changed;       ///< positions with changed bounds
+        bool* pending;      ///< position is in changed
+        int n_changed;
+
+        void alloc(Space& home) {
+            changed = home.alloc<int>(x.size());
+            pending = home.alloc<bool>(x.size());
+            for (int i = 0; i < x.size(); i++) pending[i] = false;
+            n_changed = 0;
+        }
 
         // Constructors
         // Construct Propagator
-        ModuloDomain(Home home, TArray ax)
-            : NPropDom(home, ax) {}
-        // Clone Propagator
-        ModuloDomain(Space& home, ModuloDomain& p)
-            : NPropDom(home, p) {}
+        ModuloBounds(Home home, TArray& ax, ModTable& t)
+            : Propagator(home), x(home, ax), table(t), c(home) {
+            alloc(home);
+            for (int i = 0; i < x.size(); i++) {
+                if (!x[i].x.assigned())
+                    x[i].subscribe(home, *new (home) ModAdvisor(home, *this, c, i));
+            }
+        }
+        // Clone Propagator, it is at fixpoint so nothing is pending
+        ModuloBounds(Space& home, ModuloBounds& p)
+            : Propagator(home, p) {
+            x.update(home, p.x);
+            table.update(home, p.table);
+            c.update(home, p.c);
+            alloc(home);
+        }
     public:
-        // Constructor for rewriting p during cloning
-        ModuloDomain(Space& home, Propagator& p, TArray& ax)
-            : NPropDom(home, p, ax) {};
-
         // Copy propagator during cloning
         virtual Actor* copy(Space& home);
+        // Record a changed term
+        virtual ExecStatus advise(Space& home, Advisor& a, const Delta& d);
         // Perform propagation
         virtual ExecStatus propagate(Space& home, const ModEventDelta& med);
         // Post propagator
-        static  ExecStatus post(Space& home, TArray& ax);
+        static  ExecStatus post(Home home, TArray& ax, ModTable& t);
+        // Dispose propagator
+        virtual size_t dispose(Space& home);
+        // Reschedule when there is work left
+        virtual void reschedule(Space& home);
 
         // cost function
         virtual PropCost cost(const Space& home, const ModEventDelta& med) const override;
     };
 
-    // cost, lie to make this go first
-    PropCost ModuloDomain::cost(const Space&, const ModEventDelta&) const {
+    // cost, constant work per changed term
+    PropCost ModuloBounds::cost(const Space&, const ModEventDelta&) const {
         return PropCost::unary(PropCost::LO);
     }
 
     // Copy
-    Actor* ModuloDomain::copy(Space& home) {
-        return new (home) ModuloDomain(home, *this);
+    Actor* ModuloBounds::copy(Space& home) {
+        return new (home) ModuloBounds(home, *this);
     }
 
     // Post
-    ExecStatus ModuloDomain::post(Space& home, TArray& ax) {
+    ExecStatus ModuloBounds::post(Home home, TArray& ax, ModTable& t) {
         // Fail on empty terms
         if (ax.size() == 0)
             return ES_FAILED;
@@ -632,16 +1187,46 @@ namespace Mod {
         // test if no propagator needs to be posted
         if (!ax.assigned()) {
             // post propagator
-            (void) new (home) ModuloDomain(home, ax);
+            (void) new (home) ModuloBounds(home, ax, t);
         }
 
         // return completion
         return ES_OK;
     }
 
+    // Dispose
+    size_t ModuloBounds::dispose(Space& home) {
+        for (Advisors<ModAdvisor> as(c); as(); ++as)
+            x[as.advisor().i].cancel(home, as.advisor());
+        c.dispose(home);
+        (void) Propagator::dispose(home);
+        return sizeof(*this);
+    }
+
+    // Reschedule
+    void ModuloBounds::reschedule(Space& home) {
+        if (n_changed > 0)
+            Int::IntView::schedule(home, *this, Int::ME_INT_BND);
+    }
+
+    // Advise, only bound changes and assignments matter
+    ExecStatus ModuloBounds::advise(Space& home, Advisor& _a, const Delta& d) {
+        ModAdvisor& a = static_cast<ModAdvisor&>(_a);
+        if (Int::IntView::modevent(d) == Int::ME_INT_DOM)
+            return ES_FIX;
+        if (!pending[a.i]) {
+            pending[a.i] = true;
+            changed[n_changed++] = a.i;
+        }
+        // no events after an assignment
+        if (x[a.i].x.assigned())
+            return home.ES_NOFIX_DISPOSE(c, a);
+        return ES_NOFIX;
+    }
 
     // Propagate
-    ExecStatus ModuloDomain::propagate(Space& home, const ModEventDelta& modEv) {
+    ExecStatus ModuloBounds::propagate(Space& home, const ModEventDelta& modEv) {
+        PROFILE_SCOPE(Profile::PROP_MODULO_BOUNDS);
 #if DEBUG
         // print out update
         std::cout << std::endl;
@@ -650,38 +1235,141 @@ namespace Mod {
         PP("Bounds Update", { TextF::BOLD, TextF::C_YELLOW });
         std::cout << std::endl;
 #endif
-        // intersect domain with modulus constraint
-        for (ModTerm const &_l : x) {
-            // check for update
-            if (
-                _l.x.min() % _l.modDom.mod != _l.modDom.off
-             || _l.x.max() % _l.modDom.mod != _l.modDom.off
-            ) {
-
+        // snap the changed bounds, own changes land in changed as well and are no-ops
+        while (n_changed > 0) {
+            int i = changed[--n_changed];
+            pending[i] = false;
+            const ModDomain& md = table[i];
+            if (md.mod <= 1) continue;
+
+            TView& t = x[i];
+#if DEBUG
+            // print out update
+            std::cout << "x" << t.p << " == " << md.off << " % " << md.mod << std::endl;
+            std::cout << t.x << " -> " << COL_1;
+#endif
+            GECODE_ME_CHECK(t.x.gq(home, md.up(t.x.min())));
+            GECODE_ME_CHECK(t.x.lq(home, md.down(t.x.max())));
 #if DEBUG
-                // print out update
-                std::cout << "x" << _l.p << " == " << _l.modDom.off << " % " << _l.modDom.mod << std::endl;
-                std::cout << _l.x << " -> " << COL_1;
+            // print out update
+            std::cout << t.x << std::endl;
 #endif
+        }
+
+        // subsumed once every term is assigned
+        if (x.assigned()) return home.ES_SUBSUMED(*this);
+        // return fixpoint
+        return ES_FIX;
+    }
+};
 
-                // perform update
-                auto i = ModInter<Int::IntView>(_l.modDom.off, _l.modDom.mod, _l.x.min(), _l.x.max());
-                dom(home, _l.x, i.min(), i.max());
+#include "modulo_bool.hpp"
 
-#if DEBUG
-                // print out update
-                std::cout << _l.x << std::endl;
+namespace Mod {
+    // presolve a x = c into p and count it, false if nothing was presolved (PRESOLVE off or the
+    // equation does not fit), the original equation is posted then
+    inline bool run_presolve(Home home, const IntArgs& a, const IntVarArgs& x, int c, Presolve& p, Carry* carry = nullptr,
+        bool reach = true) {
+#if PRESOLVE
+        auto start = std::chrono::steady_clock::now();
+        const bool done = presolve(home, a, x, c, p, carry != nullptr ? &carry->classes : nullptr, reach);
+        postStats.presolve += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!done) return false;
+        postStats.folded += p.folded;
+        postStats.merged += p.merged;
+        if (p.divided > 1) postStats.divided++;
+        if (home.failed() || p.x.size() == 0) postStats.decided++;
+        return true;
+#else
+        (void) home; (void) a; (void) x; (void) c; (void) p; (void) carry; (void) reach;
+        return false;
 #endif
+    }
 
+    // reachability check of a presolved equation that run_presolve skipped, false if home failed
+    inline bool run_reach(Home home, const Presolve& p) {
+        auto start = std::chrono::steady_clock::now();
+        const bool ok = reachable(p.a, p.x, p.c);
+        postStats.presolve += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!ok) {
+            static_cast<Space&>(home).fail();
+            postStats.decided++;
+        }
+        return ok;
+    }
+
+    // memo for the Modulo of a presolved equation, the carried one if its classes were carried
+    inline ModCache memo(Carry* carry) {
+        if (carry == nullptr) return ModCache();
+        if (!carry->classes.carried || !carry->memo.valid()) carry->memo = ModCache(MEMO_LIMIT);
+        return carry->memo;
+    }
+
+    // map the positions of the equation ea ex posted for x to x in pub, the table to fill or nullptr
+    inline ModTable* publish(Published* pub, const IntVarArgs& x, const IntArgs& ea, const IntVarArgs& ex) {
+        if (pub == nullptr) return nullptr;
+        pub->var.clear();
+        for (int k = 0; k < ex.size(); k++) {
+            if (ea[k] == 0) continue;
+            int i = 0;
+            while (i < x.size() && !x[i].same(ex[k])) i++;
+            pub->var.push_back(i < x.size() ? i : -1);
+        }
+        // the hack term
+        pub->var.push_back(-1);
+        return &pub->table;
+    }
+
+    // post linear and Modulo over the non-zero terms, dom holds initial congruences if not empty.
+    // The congruences Modulo finds are published to out if given, m is the memo to start from.
+    void post_modulo(Home home, const IntArgs& a, const IntVarArgs& x, int c, const std::vector<ModDomain>& dom, IntPropLevel ipl,
+        ModTable* out = nullptr, ModCache m = ModCache()) {
+        int j = 0;
+        for (int i = 0; i < x.size(); i++) {
+            if (a[i] != 0) j++;
+        }
+
+        // Turn a[] and x[] into ax[]
+        //TArray ax(home, x.size());
+        TArray ax(home, j+1);
+        j = 0;
+        for (int i = 0; i < x.size(); i++) {
+            if (a[i] == 0) {
+
+                continue;
             }
+            ax[j].a = a[i];
+            ax[j].x = x[i];
+            ax[j].p = j;
+            if (!dom.empty()) ax[j].modDom = dom[i];
+            j++;
         }
-        
-        // return fixpoint
-        return ES_FIX;
+
+        // post linear propagator
+        Profile::linear(home, a, x, c, ipl);
+
+        // THIS IS A HACK, assign a variable to instantly start propagation before branching
+        ax[j].x = IntVar(home, 0, 0);
+
+        // Post Propagator
+        // congruences found by Modulo are kept by ModuloBounds through bound changes
+        ModTable table;
+        if (DBL_BOUND || out != nullptr) {
+            table = ModTable(home, ax.size());
+            for (int i = 0; i < j; i++)
+                if (ax[i].modDom.mod > 1) table.set(i, ax[i].modDom);
+            if (out != nullptr) *out = table;
+        }
+        GECODE_ES_FAIL(Modulo<Int::IntView>::post(home, ax, IRT_EQ, c, table, m));
+#if DBL_BOUND
+        GECODE_ES_FAIL(ModuloBounds::post(home, ax, table));
+#endif
     }
 };
 
-void modulo(Home home, const IntArgs& a, const IntVarArgs& x, int c, IntPropLevel ipl) {
+// the congruences Modulo finds are published to pub if given, carry keeps classes and memo between posts
+void modulo(Home home, const IntArgs& a, const IntVarArgs& x, int c, IntPropLevel ipl,
+    Mod::Published* pub = nullptr, Mod::Carry* carry = nullptr) {
     // Ensure a and x are of the same size
     if (a.size() != x.size())
         throw Int::ArgumentSizeMismatch("Int::linear");
@@ -689,37 +1377,89 @@ void modulo(Home home, const IntArgs& a, const IntVarArgs& x, int c, IntPropLeve
     // General Post checks
     GECODE_POST;
 
+    Mod::Presolve ps;
+    if (Mod::run_presolve(home, a, x, c, ps, carry)) {
+        // failed, or nothing left for the propagators
+        if (home.failed() || ps.x.size() == 0) return;
+        Mod::post_modulo(home, ps.a, ps.x, ps.c, ps.dom, ipl, Mod::publish(pub, x, ps.a, ps.x), Mod::memo(carry));
+        return;
+    }
+    Mod::post_modulo(home, a, x, c, std::vector<Mod::ModDomain>(), ipl, Mod::publish(pub, x, a, x));
+}
+
+// 0/1 variables, linear with the Boolean specialisation of Modulo. ModuloBool only sees the 2-adic
+// part of the gcds, so when two coefficients share an odd factor the Booleans are channelled to
+// 0/1 integers and get the IntView Modulo instead.
+void modulo(Home home, const IntArgs& a, const BoolVarArgs& x, int c, IntPropLevel ipl) {
+    // Ensure a and x are of the same size
+    if (a.size() != x.size())
+        throw Int::ArgumentSizeMismatch("Int::linear");
+
+    // General Post checks
+    GECODE_POST;
+
+    // fold assigned and zero terms
+    int r = c;
     int j = 0;
     for (int i = 0; i < x.size(); i++) {
-        if (a[i] != 0) j++;
+        if (a[i] == 0) continue;
+        if (x[i].assigned()) r -= a[i] * x[i].val();
+        else j++;
     }
-
-    // Turn a[] and x[] into ax[]
-    //TArray ax(home, x.size());
-    TArray ax(home, j+1);
+    BoolVarArgs xb(j);
+    IntArgs av(j);
     j = 0;
     for (int i = 0; i < x.size(); i++) {
-        if (a[i] == 0) {
-            
-            continue;
-        }
-        ax[j].a = a[i];
-        ax[j].x = x[i];
-        ax[j].p = j;
+        if (a[i] == 0 || x[i].assigned()) continue;
+        xb[j] = x[i];
+        av[j] = a[i];
         j++;
     }
 
+    if (Mod::odd_shared(av)) {
+        IntVarArgs y(j);
+        for (int i = 0; i < j; i++) {
+            y[i] = IntVar(home, 0, 1);
+            channel(home, xb[i], y[i]);
+        }
+        Mod::post_modulo(home, av, y, r, std::vector<Mod::ModDomain>(), ipl);
+        return;
+    }
+
     // post linear propagator
-    linear(home, a, x, IRT_EQ, c);
+    linear(home, a, x, IRT_EQ, c, ipl);
+    ViewArray<Int::BoolView> xv(home, xb);
+    GECODE_ES_FAIL(Mod::ModuloBool::post(home, xv, av, r));
+}
 
-    // THIS IS A HACK, assign a variable to instantly start propagation before branching
-    ax[j].x = IntVar(home, 0, 0);
+// Automatic mode, posts Modulo only when the post-time analysis expects it to pay off
+void modulo_auto(Home home, const IntArgs& a, const IntVarArgs& x, int c, IntPropLevel ipl,
+    Mod::Published* pub = nullptr, Mod::Carry* carry = nullptr) {
+    // Ensure a and x are of the same size
+    if (a.size() != x.size())
+        throw Int::ArgumentSizeMismatch("Int::linear");
 
-    // Post Propagator
-    GECODE_ES_FAIL(Mod::Modulo::post(home, ax, IRT_EQ, c));
-#if DBL_BOUND
-    GECODE_ES_FAIL(Mod::ModuloDomain::post(home, ax));
-#endif
+    // General Post checks
+    GECODE_POST;
 
+    // the analysis looks at the equation that is actually posted. The reachability check can cost more
+    // than a whole linear solve, it only runs once Modulo is chosen.
+    Mod::Presolve ps;
+    const bool pre = Mod::run_presolve(home, a, x, c, ps, carry, false);
+    if (pre && (home.failed() || ps.x.size() == 0)) return;
+    const IntArgs& ea = pre ? ps.a : a;
+    const IntVarArgs& ex = pre ? ps.x : x;
+    const int ec = pre ? ps.c : c;
+
+    Mod::ModAnalysis an = Mod::analyse(ea, ex, ec);
+    Mod::postStats.add(an);
+
+    if (an.post) {
+        if (pre && !Mod::run_reach(home, ps)) return;
+        Mod::postStats.modulo++;
+        Mod::post_modulo(home, ea, ex, ec, pre ? ps.dom : std::vector<Mod::ModDomain>(), ipl, Mod::publish(pub, x, ea, ex),
+            pre ? Mod::memo(carry) : Mod::ModCache());
+    } else {
+        Profile::linear(home, ea, ex, ec, ipl);
+    }
 }
-